@@ -13,6 +13,7 @@
  * GNU General Public License for more details.
  */
 
+#include <console/cbmem_console.h>
 #include <console/console.h>
 #include <string.h>
 #include <arch/acpi.h>
@@ -162,5 +163,6 @@ void acpi_resume(void *wake_vec)
 	mainboard_suspend_resume();
 
 	post_code(POST_OS_RESUME);
+	cbmemc_drain_uart();
 	acpi_jump_to_wakeup(wake_vec);
 }
@@ -63,6 +63,45 @@ static void pci_mmconf_write_config32(struct bus *pbus, int bus, int devfn,
 	write32(PCI_MMIO_ADDR(bus, devfn, where, 3), value);
 }
 
+/*
+ * The registers of a function are consecutive in the ECAM window, so they
+ * can be walked with plain pointer arithmetic. Config space must still be
+ * accessed with aligned dword loads and stores, not a memcpy().
+ */
+static void pci_mmconf_read_block(struct bus *pbus, int bus, int devfn,
+				  int where, uint32_t *buf, unsigned int count)
+{
+	uint32_t *cfg = PCI_MMIO_ADDR(bus, devfn, where, 3);
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		buf[i] = read32(&cfg[i]);
+}
+
+static void pci_mmconf_moving_block(struct bus *pbus, int bus, int devfn,
+				    int where, uint32_t *value,
+				    uint32_t *moving, unsigned int count)
+{
+	uint32_t *cfg = PCI_MMIO_ADDR(bus, devfn, where, 3);
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		uint32_t ones, zeroes;
+
+		value[i] = read32(&cfg[i]);
+
+		write32(&cfg[i], 0xffffffff);
+		ones = read32(&cfg[i]);
+
+		write32(&cfg[i], 0x00000000);
+		zeroes = read32(&cfg[i]);
+
+		write32(&cfg[i], value[i]);
+
+		moving[i] = ones ^ zeroes;
+	}
+}
+
 const struct pci_bus_operations pci_ops_mmconf = {
 	.read8 = pci_mmconf_read_config8,
 	.read16 = pci_mmconf_read_config16,
@@ -70,4 +109,6 @@ const struct pci_bus_operations pci_ops_mmconf = {
 	.write8 = pci_mmconf_write_config8,
 	.write16 = pci_mmconf_write_config16,
 	.write32 = pci_mmconf_write_config32,
+	.read_block = pci_mmconf_read_block,
+	.moving_block = pci_mmconf_moving_block,
 };
@@ -0,0 +1,60 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __BINLOG_SERIALIZED_H__
+#define __BINLOG_SERIALIZED_H__
+
+#include <stdint.h>
+
+/*
+ * Stored in binlog_buffer.format_check as the offset of this string, so that
+ * the string table handed to cbmem can be checked against the log.
+ */
+#define BINLOG_CHECK_STRING	"coreboot binary log string table"
+
+/* Format offset of a record that carries already formatted text. */
+#define BINLOG_FORMAT_TEXT	0xffffffff
+
+/*
+ * One printk() call. format is the offset of the format string from the
+ * start of the ramstage image (_program). The arguments follow in the order
+ * they are consumed by the format string:
+ *  - integers, '*' widths and precisions, %c and %p: LEB128 encoded. Signed
+ *    conversions (%d, %i, '*') are zigzag encoded first.
+ *  - %s: the printed part of the string, NUL terminated.
+ *  - %n and %%: nothing.
+ * For BINLOG_FORMAT_TEXT records args holds the output, without a NUL.
+ */
+struct binlog_record {
+	uint32_t	format;
+	uint16_t	length;		/* Size of args in bytes */
+	uint8_t		level;		/* printk() message level */
+	uint8_t		reserved;
+	uint8_t		args[0];
+} __attribute__((packed));
+
+/*
+ * Records are appended back to back starting at body. Once a record doesn't
+ * fit anymore it is dropped and only counted.
+ */
+struct binlog_buffer {
+	uint32_t	size;		/* Size of body in bytes */
+	uint32_t	cursor;		/* Bytes of body in use */
+	uint32_t	dropped;	/* Number of records that didn't fit */
+	uint32_t	format_check;	/* Offset of BINLOG_CHECK_STRING */
+	uint8_t		pointer_size;	/* sizeof(void *), for %p */
+	uint8_t		reserved[3];
+	uint8_t		body[0];
+} __attribute__((packed));
+
+#endif
@@ -31,4 +31,12 @@ size_t ulz4fn(const void *src, size_t srcn, void *dst, size_t dstn);
 /* Same as ulz4fn() but does not perform any bounds checks. */
 size_t ulz4f(const void *src, void *dst);
 
+/* Same as ulz4fn() but pulls the compressed input through the read() callback
+ * in small windows, so the whole input never has to be in memory and the
+ * output doesn't need any in-place margin. read() is called with arg and has
+ * to fill buf with up to size bytes of the next input, returning the amount
+ * of bytes provided or 0 on error or end of input. */
+size_t ulz4fn_stream(size_t (*read)(void *arg, void *buf, size_t size),
+		     void *arg, void *dst, size_t dstn);
+
 #endif	/* _COMMONLIB_COMPRESSION_H_ */
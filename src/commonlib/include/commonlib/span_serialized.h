@@ -0,0 +1,46 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __SPAN_SERIALIZED_H__
+#define __SPAN_SERIALIZED_H__
+
+#include <stdint.h>
+
+#define SPAN_NAME_LEN	22
+
+enum span_event_type {
+	SPAN_BEGIN = 'B',
+	SPAN_END = 'E',
+};
+
+struct span_event {
+	uint64_t	stamp;		/* Raw timestamp_get() value */
+	uint8_t		type;		/* enum span_event_type */
+	uint8_t		depth;		/* Nesting level, 0 is outermost */
+	char		name[SPAN_NAME_LEN];	/* NUL terminated, truncated */
+} __attribute__((packed));
+
+/*
+ * The events form a ring buffer. num_events counts all events ever recorded,
+ * the newest event is at index (num_events - 1) % max_events. Once the ring
+ * wraps the oldest events are overwritten.
+ */
+struct span_buffer {
+	uint32_t	max_events;
+	uint32_t	num_events;
+	uint32_t	tick_freq_mhz;
+	uint32_t	reserved;
+	struct span_event events[0]; /* Variable number of entries */
+} __attribute__((packed));
+
+#endif
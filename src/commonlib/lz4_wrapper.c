@@ -200,3 +200,185 @@ size_t ulz4f(const void *src, void *dst)
 	/* LZ4 uses signed size parameters, so can't just use ((u32)-1) here. */
 	return ulz4fn(src, 1*GiB, dst, 1*GiB);
 }
+
+/* Input window for streaming decompression, allocated on the stack. */
+#define LZ4_STREAM_WINDOW 512
+
+struct lz4_stream {
+	size_t (*read)(void *arg, void *buf, size_t size);
+	void *arg;
+	uint8_t buf[LZ4_STREAM_WINDOW];
+	size_t pos;
+	size_t len;
+	/* Compressed bytes left in the current block. */
+	size_t block_left;
+};
+
+static int lz4_stream_fill(struct lz4_stream *s)
+{
+	s->pos = 0;
+	s->len = s->read(s->arg, s->buf, sizeof(s->buf));
+	return s->len ? 0 : -1;
+}
+
+/* Copy n bytes of input to dst. Pass a NULL dst to skip input. */
+static int lz4_stream_copy(struct lz4_stream *s, void *dst, size_t n)
+{
+	while (n) {
+		size_t chunk;
+
+		if (s->pos == s->len && lz4_stream_fill(s))
+			return -1;
+
+		chunk = MIN(n, s->len - s->pos);
+		if (dst != NULL) {
+			memcpy(dst, &s->buf[s->pos], chunk);
+			dst += chunk;
+		}
+		s->pos += chunk;
+		n -= chunk;
+	}
+
+	return 0;
+}
+
+/* Read n bytes of the current block. */
+static int lz4_stream_block_copy(struct lz4_stream *s, void *dst, size_t n)
+{
+	if (n > s->block_left)
+		return -1;
+	s->block_left -= n;
+	return lz4_stream_copy(s, dst, n);
+}
+
+static int lz4_stream_block_len(struct lz4_stream *s, size_t *len)
+{
+	uint8_t b;
+
+	do {
+		if (lz4_stream_block_copy(s, &b, sizeof(b)))
+			return -1;
+		*len += b;
+	} while (b == 255);
+
+	return 0;
+}
+
+/* Decode one compressed block, returning the decompressed size or < 0. */
+static int lz4_stream_block(struct lz4_stream *s, uint8_t *out,
+				uint8_t *out_end)
+{
+	uint8_t *const block_start = out;
+
+	while (s->block_left) {
+		uint8_t token;
+		uint8_t le_offset[2];
+		size_t len;
+		size_t offset;
+		const uint8_t *match;
+
+		if (lz4_stream_block_copy(s, &token, sizeof(token)))
+			return -1;
+
+		len = token >> ML_BITS;
+		if (len == RUN_MASK && lz4_stream_block_len(s, &len))
+			return -1;
+
+		if (len > (size_t)(out_end - out))
+			return -1;	/* output overrun */
+		if (lz4_stream_block_copy(s, out, len))
+			return -1;
+		out += len;
+
+		/* The last sequence of a block only has literals. */
+		if (!s->block_left)
+			break;
+
+		if (lz4_stream_block_copy(s, le_offset, sizeof(le_offset)))
+			return -1;
+		offset = le_offset[0] | (le_offset[1] << 8);
+		if (offset == 0 || offset > (size_t)(out - block_start))
+			return -1;	/* blocks are independent */
+
+		len = token & ML_MASK;
+		if (len == ML_MASK && lz4_stream_block_len(s, &len))
+			return -1;
+		len += MINMATCH;
+
+		if (len > (size_t)(out_end - out))
+			return -1;	/* output overrun */
+
+		/* Matches may overlap their own output. */
+		match = out - offset;
+		if (offset >= len) {
+			memcpy(out, match, len);
+			out += len;
+		} else {
+			while (len--)
+				*out++ = *match++;
+		}
+	}
+
+	return out - block_start;
+}
+
+size_t ulz4fn_stream(size_t (*read)(void *arg, void *buf, size_t size),
+		     void *arg, void *dst, size_t dstn)
+{
+	struct lz4_stream s = { .read = read, .arg = arg };
+	uint8_t *out = dst;
+	uint8_t *const out_end = out + dstn;
+	int has_block_checksum;
+
+	{
+		struct lz4_frame_header h;
+
+		if (lz4_stream_copy(&s, &h, sizeof(h)))
+			return 0;	/* input overrun */
+
+		if (read_le32(&h.magic) != LZ4F_MAGICNUMBER || h.version != 1)
+			return 0;	/* unknown format */
+		if (h.reserved0 || h.reserved1 || h.reserved2)
+			return 0;	/* reserved must be zero */
+		if (!h.independent_blocks)
+			return 0;	/* we don't support block dependency */
+		has_block_checksum = h.has_block_checksum;
+
+		/* Skip content size and header checksum. */
+		if (lz4_stream_copy(&s, NULL, (h.has_content_size ?
+				    sizeof(uint64_t) : 0) + sizeof(uint8_t)))
+			return 0;
+	}
+
+	while (1) {
+		struct lz4_block_header b;
+
+		if (lz4_stream_copy(&s, &b.raw, sizeof(b.raw)))
+			break;			/* input overrun */
+		b.raw = read_le32(&b.raw);
+
+		if (!b.size)
+			return out - (uint8_t *)dst;	/* success */
+
+		s.block_left = b.size;
+
+		if (b.not_compressed) {
+			if (b.size > (size_t)(out_end - out))
+				break;		/* output overrun */
+			if (lz4_stream_block_copy(&s, out, b.size))
+				break;
+			out += b.size;
+		} else {
+			int ret = lz4_stream_block(&s, out, out_end);
+			if (ret < 0)
+				break;		/* decompression error */
+			out += ret;
+		}
+
+		if (has_block_checksum &&
+		    lz4_stream_copy(&s, NULL, sizeof(uint32_t)))
+			break;
+	}
+
+	return 0;
+}
@@ -55,6 +55,34 @@ void console_tx_byte(unsigned char byte)
 	__spiconsole_tx_byte(byte);
 }
 
+void console_tx_bytes(const void *data, size_t length)
+{
+	const unsigned char *bytes = data;
+	size_t start, i;
+
+	for (i = 0; i < length; i++) {
+		__cbmemc_tx_byte(bytes[i]);
+		__spkmodem_tx_byte(bytes[i]);
+		__qemu_debugcon_tx_byte(bytes[i]);
+		__ne2k_tx_byte(bytes[i]);
+		__spiconsole_tx_byte(bytes[i]);
+	}
+
+	/* Hand out the text between newlines, converting each newline. */
+	for (start = 0; start < length; start = i + 1) {
+		for (i = start; i < length && bytes[i] != '\n'; i++)
+			;
+
+		__uart_tx_bytes(&bytes[start], i - start);
+		__usb_tx_bytes(&bytes[start], i - start);
+
+		if (i < length) {
+			__uart_tx_bytes("\r\n", 2);
+			__usb_tx_bytes("\r\n", 2);
+		}
+	}
+}
+
 void console_tx_flush(void)
 {
 	__uart_tx_flush();
@@ -71,8 +99,7 @@ void console_write_line(uint8_t *buffer, size_t number_of_bytes)
 	}
 
 	/* Output the console data */
-	while (number_of_bytes--)
-		console_tx_byte(*buffer++);
+	console_tx_bytes(buffer, number_of_bytes);
 }
 
 
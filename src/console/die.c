@@ -19,12 +19,15 @@
 #include <halt.h>
 
 #ifndef __ROMCC__
+#include <console/cbmem_console.h>
+
 #define NORETURN __attribute__((noreturn))
 
 /* Report a fatal error */
 void NORETURN die(const char *msg)
 {
 	printk(BIOS_EMERG, "%s", msg);
+	cbmemc_drain_uart();
 	halt();
 }
 #endif
@@ -17,6 +17,7 @@
  * blatantly copied from linux/kernel/printk.c
  */
 
+#include <console/cbmem_console.h>
 #include <console/console.h>
 #include <console/streams.h>
 #include <console/vtxprintf.h>
@@ -39,6 +40,68 @@ static void wrap_putchar(unsigned char byte, void *data)
 	do_putchar(byte);
 }
 
+/*
+ * Output is collected on the stack and handed to the console drivers in
+ * chunks, so that they don't have to be polled for every single byte.
+ */
+struct printk_buffer {
+	size_t len;
+	unsigned char data[CONFIG_CONSOLE_TX_BUFFER_SIZE];
+};
+
+static void buffer_putchar(unsigned char byte, void *data)
+{
+	struct printk_buffer *buf = data;
+
+	buf->data[buf->len++] = byte;
+	if (buf->len == sizeof(buf->data)) {
+		console_tx_bytes(buf->data, buf->len);
+		buf->len = 0;
+	}
+}
+
+static int console_vtxprintf(const char *fmt, va_list args)
+{
+	struct printk_buffer buf;
+	int i;
+
+	if (!CONFIG_CONSOLE_TX_BUFFER_SIZE)
+		return vtxprintf(wrap_putchar, fmt, args, NULL);
+
+	buf.len = 0;
+	i = vtxprintf(buffer_putchar, fmt, args, &buf);
+	if (buf.len)
+		console_tx_bytes(buf.data, buf.len);
+
+	return i;
+}
+
+#define BINARY_LOG	(IS_ENABLED(CONFIG_CONSOLE_CBMEM_BINARY_LOG) && \
+			 ENV_RAMSTAGE)
+
+/* Consoles that still need the formatted text next to the binary log. */
+#define TEXT_CONSOLE	(IS_ENABLED(CONFIG_CONSOLE_SERIAL) || \
+			 IS_ENABLED(CONFIG_CONSOLE_USB) || \
+			 IS_ENABLED(CONFIG_CONSOLE_NE2K) || \
+			 IS_ENABLED(CONFIG_SPKMODEM) || \
+			 IS_ENABLED(CONFIG_CONSOLE_QEMU_DEBUGCON) || \
+			 IS_ENABLED(CONFIG_SPI_CONSOLE))
+
+static int console_printk(int msg_level, const char *fmt, va_list args)
+{
+	va_list copy;
+
+	if (BINARY_LOG) {
+		va_copy(copy, args);
+		cbmem_binlog_vprintk(msg_level, fmt, copy);
+		va_end(copy);
+		if (!TEXT_CONSOLE)
+			return 0;
+	}
+
+	return console_vtxprintf(fmt, args);
+}
+
 int do_printk(int msg_level, const char *fmt, ...)
 {
 	va_list args;
@@ -62,7 +125,7 @@ int do_printk(int msg_level, const char *fmt, ...)
 #endif
 
 	va_start(args, fmt);
-	i = vtxprintf(wrap_putchar, fmt, args, NULL);
+	i = console_printk(msg_level, fmt, args);
 	va_end(args);
 
 	console_tx_flush();
@@ -84,7 +147,7 @@ void do_printk_va_list(int msg_level, const char *fmt, va_list args)
 {
 	if (!console_log_level(msg_level))
 		return;
-	vtxprintf(wrap_putchar, fmt, args, NULL);
+	console_printk(msg_level, fmt, args);
 	console_tx_flush();
 }
 #endif /* CONFIG_CHROMEOS */
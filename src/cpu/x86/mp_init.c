@@ -14,6 +14,7 @@
  * GNU General Public License for more details.
  */
 
+#include <bootstate.h>
 #include <console/console.h>
 #include <stdint.h>
 #include <rmodule.h>
@@ -34,8 +35,10 @@
 #include <lib.h>
 #include <smp/atomic.h>
 #include <smp/spinlock.h>
+#include <string.h>
 #include <symbols.h>
 #include <thread.h>
+#include <timer.h>
 
 #define MAX_APIC_IDS 256
 
@@ -137,6 +140,23 @@ struct cpu_map {
 /* Keep track of APIC and device structure for each CPU. */
 static struct cpu_map cpus[CONFIG_MAX_CPUS];
 
+struct mp_callback {
+	void (*func)(void *);
+	void *arg;
+};
+
+/*
+ * Per-CPU mailbox used to hand work to the APs after initialization. A
+ * non-NULL slot holds a job which the AP has not picked up yet. The AP
+ * copies the job and clears its slot before running it.
+ */
+static struct mp_callback *ap_callbacks[CONFIG_MAX_CPUS];
+/* Backing storage for the jobs posted in ap_callbacks[]. */
+static struct mp_callback ap_jobs[CONFIG_MAX_CPUS];
+
+/* Number of APs waiting in ap_wait_for_instruction(). */
+static int ap_work_count;
+
 static inline void barrier_wait(atomic_t *b)
 {
 	while (atomic_read(b) == 0) {
@@ -185,6 +205,236 @@ static void ap_do_flight_plan(void)
 	}
 }
 
+static struct mp_callback *read_callback(struct mp_callback **slot)
+{
+	struct mp_callback *ret;
+
+	asm volatile ("mov	%1, %0\n"
+		: "=r" (ret)
+		: "m" (*slot)
+		: "memory"
+	);
+	return ret;
+}
+
+static void store_callback(struct mp_callback **slot, struct mp_callback *val)
+{
+	asm volatile ("mov	%1, %0\n"
+		: "=m" (*slot)
+		: "r" (val)
+		: "memory"
+	);
+}
+
+static void ap_wait_for_instruction(void)
+{
+	struct mp_callback lcb;
+	struct mp_callback **per_cpu_slot;
+
+	if (!IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK))
+		return;
+
+	per_cpu_slot = &ap_callbacks[cpu_index()];
+
+	while (1) {
+		struct mp_callback *cb = read_callback(per_cpu_slot);
+
+		if (cb == NULL) {
+			asm ("pause");
+			continue;
+		}
+
+		/* Copy to local variable before signalling consumption. */
+		memcpy(&lcb, cb, sizeof(lcb));
+		mfence();
+		store_callback(per_cpu_slot, NULL);
+		lcb.func(lcb.arg);
+	}
+}
+
+/* Returns 0 once the slot is empty, < 0 if expire_us elapsed before. */
+static int wait_for_empty_slot(struct mp_callback **slot, long expire_us)
+{
+	struct stopwatch sw;
+
+	if (expire_us > 0)
+		stopwatch_init_usecs_expire(&sw, expire_us);
+
+	while (read_callback(slot) != NULL) {
+		if (expire_us > 0 && stopwatch_expired(&sw))
+			return -1;
+		asm ("pause");
+	}
+
+	return 0;
+}
+
+/* Post a job into the mailbox of an AP. The AP has to be idle. */
+static void post_job(int cpu, void (*func)(void *), void *arg)
+{
+	ap_jobs[cpu].func = func;
+	ap_jobs[cpu].arg = arg;
+	mfence();
+	store_callback(&ap_callbacks[cpu], &ap_jobs[cpu]);
+}
+
+int mp_run_on_ap(int cpu, void (*func)(void *), void *arg, long expire_us)
+{
+	if (!IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK)) {
+		printk(BIOS_ERR, "APs already parked. "
+		       "PARALLEL_MP_AP_WORK not selected.\n");
+		return -1;
+	}
+
+	if (cpu <= 0 || cpu > ap_work_count) {
+		printk(BIOS_ERR, "Invalid AP %d for work.\n", cpu);
+		return -1;
+	}
+
+	/* Wait for the previous job to be picked up. */
+	if (wait_for_empty_slot(&ap_callbacks[cpu], expire_us)) {
+		printk(BIOS_ERR, "AP %d busy, job not queued.\n", cpu);
+		return -1;
+	}
+
+	post_job(cpu, func, arg);
+
+	return 0;
+}
+
+int mp_get_ap_count(void)
+{
+	return ap_work_count;
+}
+
+/* Atomically increment v and return its previous value. */
+static inline int atomic_fetch_inc(atomic_t *v)
+{
+	int ret = 1;
+
+	asm volatile ("lock; xaddl %0, %1"
+		: "+r" (ret), "+m" (v->counter)
+		:
+		: "memory"
+	);
+	return ret;
+}
+
+int mp_run_on_aps(void (*func)(void *), void *arg, long expire_us)
+{
+	int cpu;
+	int posted = 0;
+
+	for (cpu = 1; cpu <= ap_work_count; cpu++) {
+		if (mp_run_on_ap(cpu, func, arg, expire_us) == 0)
+			posted++;
+	}
+
+	return posted;
+}
+
+/* State of the current mp_run_on_all_cpus() call. */
+static struct {
+	void (*func)(void *);
+	void *arg;
+	atomic_t done;
+} all_cpus_job;
+
+static void run_and_signal(void *unused)
+{
+	all_cpus_job.func(all_cpus_job.arg);
+	mfence();
+	atomic_inc(&all_cpus_job.done);
+}
+
+int mp_run_on_all_cpus(void (*func)(void *), void *arg, long expire_us)
+{
+	int num_aps;
+
+	all_cpus_job.func = func;
+	all_cpus_job.arg = arg;
+	atomic_set(&all_cpus_job.done, 0);
+	mfence();
+
+	num_aps = mp_run_on_aps(run_and_signal, NULL, expire_us);
+
+	func(arg);
+
+	/* Completion barrier, all APs which got the job have to finish. */
+	while (atomic_read(&all_cpus_job.done) != num_aps)
+		asm ("pause");
+	mfence();
+
+	return num_aps + 1;
+}
+
+/* State of the current mp_run_queue() call. */
+static struct {
+	void (*func)(void *arg, int index);
+	void *arg;
+	int count;
+	atomic_t next;
+} job_queue;
+
+static void job_queue_worker(void *unused)
+{
+	int index;
+
+	while ((index = atomic_fetch_inc(&job_queue.next)) < job_queue.count)
+		job_queue.func(job_queue.arg, index);
+}
+
+int mp_run_queue(void (*func)(void *arg, int index), void *arg, int count)
+{
+	if (count <= 0)
+		return 0;
+
+	job_queue.func = func;
+	job_queue.arg = arg;
+	job_queue.count = count;
+	atomic_set(&job_queue.next, 0);
+
+	/*
+	 * APs which didn't pick up their previous job yet are left out, the
+	 * others take over their share.
+	 */
+	return mp_run_on_all_cpus(job_queue_worker, NULL, 100);
+}
+
+static void park_this_cpu(void *unused)
+{
+	stop_this_cpu();
+}
+
+void mp_park_aps(void)
+{
+	int cpu;
+	int num_aps = ap_work_count;
+
+	if (num_aps == 0)
+		return;
+
+	/* No more work can be handed out once parking starts. */
+	ap_work_count = 0;
+
+	for (cpu = 1; cpu <= num_aps; cpu++) {
+		if (wait_for_empty_slot(&ap_callbacks[cpu],
+					1000 * USECS_PER_MSEC)) {
+			printk(BIOS_ERR, "AP %d busy, not parked.\n", cpu);
+			continue;
+		}
+		post_job(cpu, park_this_cpu, NULL);
+	}
+}
+
+static void park_aps(void *unused)
+{
+	mp_park_aps();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, park_aps, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, park_aps, NULL);
+
 /* By the time APs call ap_init() caching has been setup, and microcode has
  * been loaded. */
 static void asmlinkage ap_init(unsigned int cpu)
@@ -687,6 +937,7 @@ struct mp_state {
 	size_t perm_smsize;
 	size_t smm_save_state_size;
 	int do_smm;
+	int smm_parallel_relocation;
 } mp_state;
 
 static int is_smm_enabled(void)
@@ -725,12 +976,14 @@ static void asmlinkage smm_do_relocation(void *arg)
 	}
 
 	/*
-	 * The permanent handler runs with all cpus concurrently. Precalculate
-	 * the location of the new SMBASE. If using SMM modules then this
-	 * calculation needs to match that of the module loader.
+	 * The permanent handler runs with all cpus concurrently. The module
+	 * loader already placed each CPU's staggered SMBASE.
 	 */
-	perm_smbase = mp_state.perm_smbase;
-	perm_smbase -= cpu * runtime->save_state_size;
+	perm_smbase = smm_get_cpu_smbase(cpu);
+	if (perm_smbase == 0) {
+		printk(BIOS_CRIT, "No permanent SMBASE for CPU %d\n", cpu);
+		return;
+	}
 
 	printk(BIOS_DEBUG, "New SMBASE 0x%08lx\n", perm_smbase);
 
@@ -826,6 +1079,24 @@ static void load_smm_handlers(void)
 	 */
 	if (is_smm_enabled() && mp_state.ops.pre_mp_smm_init != NULL)
 		mp_state.ops.pre_mp_smm_init();
+
+	if (is_smm_enabled() && mp_state.ops.parallel_smm_relocation != NULL &&
+	    mp_state.ops.parallel_smm_relocation()) {
+		printk(BIOS_DEBUG, "Doing parallel SMM relocation.\n");
+		mp_state.smm_parallel_relocation = 1;
+	}
+}
+
+/*
+ * Default per CPU SMM trigger. The relocation SMIs only have to be
+ * serialized when all CPUs share the save state in the default SMRAM.
+ */
+static void smm_initiate_relocation_default(void)
+{
+	if (mp_state.smm_parallel_relocation)
+		smm_initiate_relocation_parallel();
+	else
+		smm_initiate_relocation();
 }
 
 /* Trigger SMM as part of MP flight record. */
@@ -845,8 +1116,8 @@ static struct mp_flight_record mp_steps[] = {
 	MP_FR_NOBLOCK_APS(trigger_smm_relocation, trigger_smm_relocation),
 	/* Initialize each CPU through the driver framework. */
 	MP_FR_BLOCK_APS(mp_initialize_cpu, mp_initialize_cpu),
-	/* Wait for APs to finish everything else then let them park. */
-	MP_FR_BLOCK_APS(NULL, NULL),
+	/* Wait for APs to finish then optionally start looking for work. */
+	MP_FR_BLOCK_APS(ap_wait_for_instruction, NULL),
 };
 
 static void fill_mp_state(struct mp_state *state, const struct mp_ops *ops)
@@ -865,12 +1136,13 @@ static void fill_mp_state(struct mp_state *state, const struct mp_ops *ops)
 					&state->smm_save_state_size);
 
 	/*
-	 * Default to smm_initiate_relocation() if trigger callback isn't
-	 * provided.
+	 * Default to smm_initiate_relocation_default() if trigger callback
+	 * isn't provided.
 	 */
 	if (IS_ENABLED(CONFIG_HAVE_SMI_HANDLER) &&
 		ops->per_cpu_smm_trigger == NULL)
-		mp_state.ops.per_cpu_smm_trigger = smm_initiate_relocation;
+		mp_state.ops.per_cpu_smm_trigger =
+			smm_initiate_relocation_default;
 }
 
 int mp_init_with_smm(struct bus *cpu_bus, const struct mp_ops *mp_ops)
@@ -915,6 +1187,9 @@ int mp_init_with_smm(struct bus *cpu_bus, const struct mp_ops *mp_ops)
 
 	restore_default_smm_area(default_smm_area);
 
+	if (ret == 0 && IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK))
+		ap_work_count = mp_state.cpu_count - 1;
+
 	/* Signal callback on success if it's provided. */
 	if (ret == 0 && mp_state.ops.post_mp_init != NULL)
 		mp_state.ops.post_mp_init();
@@ -35,6 +35,7 @@
 #include <arch/cpu.h>
 #include <arch/acpi.h>
 #include <memrange.h>
+#include <timer.h>
 #if CONFIG_X86_AMD_FIXED_MTRRS
 #include <cpu/amd/mtrr.h>
 #define MTRR_FIXED_WRBACK_BITS (MTRR_READ_MEM | MTRR_WRITE_MEM)
@@ -287,18 +288,26 @@ static void calc_fixed_mtrrs(void)
 	fixed_mtrr_types_initialized = 1;
 }
 
-static void commit_fixed_mtrrs(void)
+/* The fixed MTRR MSRs, filled in once by calc_fixed_msrs(). */
+static msr_t fixed_msrs[NUM_FIXED_MTRRS];
+static unsigned long fixed_msr_index[NUM_FIXED_MTRRS];
+
+static void calc_fixed_msrs(void)
 {
+	static int fixed_msrs_initialized;
 	int i;
 	int j;
 	int msr_num;
 	int type_index;
-	/* 8 ranges per msr. */
-	msr_t fixed_msrs[NUM_FIXED_MTRRS];
-	unsigned long msr_index[NUM_FIXED_MTRRS];
+
+	if (fixed_msrs_initialized)
+		return;
+
+	calc_fixed_mtrrs();
 
 	memset(&fixed_msrs, 0, sizeof(fixed_msrs));
 
+	/* 8 ranges per msr. */
 	msr_num = 0;
 	type_index = 0;
 	for (i = 0; i < ARRAY_SIZE(fixed_mtrr_desc); i++) {
@@ -308,7 +317,7 @@ static void commit_fixed_mtrrs(void)
 		desc = &fixed_mtrr_desc[i];
 		num_ranges = (desc->end - desc->begin) / desc->step;
 		for (j = 0; j < num_ranges; j += RANGES_PER_FIXED_MTRR) {
-			msr_index[msr_num] = desc->msr_index_base +
+			fixed_msr_index[msr_num] = desc->msr_index_base +
 				(j / RANGES_PER_FIXED_MTRR);
 			fixed_msrs[msr_num].lo |=
 				fixed_mtrr_types[type_index++] << 0;
@@ -332,17 +341,39 @@ static void commit_fixed_mtrrs(void)
 
 	for (i = 0; i < ARRAY_SIZE(fixed_msrs); i++)
 		printk(BIOS_DEBUG, "MTRR: Fixed MSR 0x%lx 0x%08x%08x\n",
-		       msr_index[i], fixed_msrs[i].hi, fixed_msrs[i].lo);
+		       fixed_msr_index[i], fixed_msrs[i].hi, fixed_msrs[i].lo);
+
+	fixed_msrs_initialized = 1;
+}
+
+static int msr_equal(msr_t a, msr_t b)
+{
+	return a.lo == b.lo && a.hi == b.hi;
+}
+
+static void commit_fixed_mtrrs(void)
+{
+	int i;
+
+	/*
+	 * APs started through the MP code already got the MTRRs of the BSP.
+	 * Don't go through a cache disable window if nothing changes.
+	 */
+	for (i = 0; i < ARRAY_SIZE(fixed_msrs); i++)
+		if (!msr_equal(rdmsr(fixed_msr_index[i]), fixed_msrs[i]))
+			break;
+	if (i == ARRAY_SIZE(fixed_msrs))
+		return;
 
 	disable_cache();
 	for (i = 0; i < ARRAY_SIZE(fixed_msrs); i++)
-		wrmsr(msr_index[i], fixed_msrs[i]);
+		wrmsr(fixed_msr_index[i], fixed_msrs[i]);
 	enable_cache();
 }
 
 void x86_setup_fixed_mtrrs_no_enable(void)
 {
-	calc_fixed_mtrrs();
+	calc_fixed_msrs();
 	commit_fixed_mtrrs();
 }
 
@@ -739,10 +770,41 @@ static void prepare_var_mtrrs(struct memranges *addr_space, int def_type,
 	sol->num_used = var_state.mtrr_index;
 }
 
+static int var_mtrrs_match(const struct var_mtrr_solution *sol)
+{
+	msr_t msr;
+	int i;
+
+	msr = rdmsr(MTRR_DEF_TYPE_MSR);
+	if (!(msr.lo & MTRR_DEF_TYPE_EN) ||
+	    (msr.lo & 0xff) != sol->mtrr_default_type)
+		return 0;
+
+	for (i = 0; i < sol->num_used; i++) {
+		if (!msr_equal(rdmsr(MTRR_PHYS_BASE(i)), sol->regs[i].base) ||
+		    !msr_equal(rdmsr(MTRR_PHYS_MASK(i)), sol->regs[i].mask))
+			return 0;
+	}
+
+	for (; i < total_mtrrs; i++) {
+		msr = rdmsr(MTRR_PHYS_MASK(i));
+		if (msr.lo || msr.hi)
+			return 0;
+		msr = rdmsr(MTRR_PHYS_BASE(i));
+		if (msr.lo || msr.hi)
+			return 0;
+	}
+
+	return 1;
+}
+
 static void commit_var_mtrrs(const struct var_mtrr_solution *sol)
 {
 	int i;
 
+	if (var_mtrrs_match(sol))
+		return;
+
 	/* Write out the variable MTRRs. */
 	disable_cache();
 	for (i = 0; i < sol->num_used; i++) {
@@ -775,18 +837,49 @@ void x86_setup_var_mtrrs(unsigned int address_bits, unsigned int above4gb)
 	commit_var_mtrrs(sol);
 }
 
+/* Time each CPU spent in x86_setup_mtrrs(), for the report below. */
+static struct {
+	long usecs;
+	int done;
+} mtrr_setup_time[CONFIG_MAX_CPUS];
+
 void x86_setup_mtrrs(void)
 {
-	int address_size;
+	static int address_size;
+	struct stopwatch sw;
+	unsigned long cpu;
+
+	stopwatch_init(&sw);
 
 	x86_setup_fixed_mtrrs();
-	address_size = cpu_phys_address_size();
-	printk(BIOS_DEBUG, "CPU physical address size: %d bits\n",
-		address_size);
+	if (!address_size) {
+		address_size = cpu_phys_address_size();
+		printk(BIOS_DEBUG, "CPU physical address size: %d bits\n",
+			address_size);
+	}
 	/* Always handle addresses above 4GiB. */
 	x86_setup_var_mtrrs(address_size, 1);
+
+	cpu = cpu_index();
+	if (cpu < ARRAY_SIZE(mtrr_setup_time)) {
+		mtrr_setup_time[cpu].usecs = stopwatch_duration_usecs(&sw);
+		mtrr_setup_time[cpu].done = 1;
+	}
 }
 
+static void report_mtrr_setup(void *unused)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(mtrr_setup_time); i++) {
+		if (mtrr_setup_time[i].done)
+			printk(BIOS_DEBUG, "MTRR: CPU %d setup took %ld usecs\n",
+			       i, mtrr_setup_time[i].usecs);
+	}
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, report_mtrr_setup, NULL);
+
 void x86_setup_mtrrs_with_detect(void)
 {
 	detect_var_mtrrs();
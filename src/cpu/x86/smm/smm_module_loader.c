@@ -48,6 +48,14 @@ extern unsigned char _binary_smmstub_start[];
 /* This is the SMM handler that the stub calls. It is encoded as an rmodule. */
 extern unsigned char _binary_smm_start[];
 
+/*
+ * SMBASE of each CPU running the permanent handler. It is filled in by
+ * smm_load_module() from the same placement as the staggered entry points so
+ * the relocation handler only has to look up its target.
+ */
+static uintptr_t cpu_smbase[CONFIG_MAX_CPUS];
+static int num_cpu_smbases;
+
 /* Per CPU minimum stack size. */
 #define SMM_MINIMUM_STACK_SIZE 32
 
@@ -86,13 +94,16 @@ static void smm_place_jmp_instructions(void *entry_start, int stride, int num,
 		uint32_t disp = (uint32_t)jmp_target;
 
 		disp -= sizeof(entry) + (uint32_t)cur;
-		printk(BIOS_DEBUG,
-		       "SMM Module: placing jmp sequence at %p rel16 0x%04x\n",
-		       cur, disp);
 		entry.rel16 = disp;
 		memcpy(cur, &entry, sizeof(entry));
 		cur -= stride;
 	}
+
+	/* One line for all entries: with many CPUs a line per entry point
+	 * adds up to a noticeable amount of serial console time. */
+	printk(BIOS_DEBUG,
+	       "SMM Module: placed %d jmp sequences from %p down to %p\n",
+	       num, entry_start, cur + stride);
 }
 
 /* Place stacks in base -> base + size region, but ensure the stacks don't
@@ -166,38 +177,86 @@ static void smm_stub_place_staggered_entry_points(char *base,
  * The save state and stack areas are treated as contiguous for the number of
  * concurrent areas requested. The save state always lives at the top of SMRAM
  * space, and the entry point is at offset 0x8000.
+ *
+ * The complete placement is computed before anything is written so that a
+ * CPU count whose staggered save states would run into the stub or whose
+ * staggered entry points would run into the stacks is refused up front.
  */
+struct smm_stub_layout {
+	char *save_state_bottom;
+	char *entry_bottom;
+	char *stub;
+	int stub_size;
+};
+
+static int smm_stub_compute_layout(char *base,
+	const struct smm_loader_params *params, const struct rmodule *smm_stub,
+	struct smm_stub_layout *layout)
+{
+	int per_cpu_size = params->per_cpu_save_state_size;
+	int num_save_states = params->num_concurrent_save_states;
+
+	/* The save states extend down from the top of the default SMRAM. */
+	layout->save_state_bottom = &base[SMM_DEFAULT_SIZE];
+	layout->save_state_bottom -= per_cpu_size * num_save_states;
+
+	/* Assume the stub is always small enough to live within upper half of
+	 * SMRAM region after the save state space has been allocated. */
+	layout->stub = &base[SMM_ENTRY_OFFSET];
+	layout->stub_size = rmodule_memory_size(smm_stub);
+
+	/* Adjust for jmp instruction sequence. */
+	if (rmodule_entry_offset(smm_stub) != 0) {
+		int entry_sequence_size = sizeof(struct smm_entry_ins);
+		/* Align up to 16 bytes. */
+		entry_sequence_size += 15;
+		entry_sequence_size &= ~15;
+		layout->stub += entry_sequence_size;
+	}
+
+	/* The staggered entry points extend below SMM_ENTRY_OFFSET by the
+	 * number of concurrent save states - 1 and save state size. */
+	layout->entry_bottom = &base[SMM_ENTRY_OFFSET];
+	layout->entry_bottom -= per_cpu_size * (num_save_states - 1);
+
+	if (layout->stub + layout->stub_size > layout->save_state_bottom) {
+		printk(BIOS_ERR, "SMM Module: %d save states of 0x%x bytes "
+		       "overlap the stub at %p\n", num_save_states,
+		       per_cpu_size, layout->stub);
+		return -1;
+	}
+
+	if (layout->entry_bottom <= base) {
+		printk(BIOS_ERR, "SMM Module: %d entry points staggered by "
+		       "0x%x bytes extend below %p\n", num_save_states,
+		       per_cpu_size, base);
+		return -1;
+	}
+
+	return 0;
+}
+
 static int smm_module_setup_stub(void *smbase, struct smm_loader_params *params)
 {
-	int total_save_state_size;
-	int smm_stub_size;
-	int stub_entry_offset;
-	char *smm_stub_loc;
+	struct smm_stub_layout layout;
 	void *stacks_top;
-	int size;
 	char *base;
 	int i;
 	struct smm_stub_params *stub_params;
 	struct rmodule smm_stub;
 
 	base = smbase;
-	size = SMM_DEFAULT_SIZE;
 
 	/* The number of concurrent stacks cannot exceed CONFIG_MAX_CPUS. */
 	if (params->num_concurrent_stacks > CONFIG_MAX_CPUS)
 		return -1;
 
-	/* Fail if can't parse the smm stub rmodule. */
-	if (rmodule_parse(&_binary_smmstub_start, &smm_stub))
+	/* There has to be at least one save state. */
+	if (params->num_concurrent_save_states < 1)
 		return -1;
 
-	/* Adjust remaining size to account for save state. */
-	total_save_state_size = params->per_cpu_save_state_size *
-	                        params->num_concurrent_save_states;
-	size -= total_save_state_size;
-
-	/* The save state size encroached over the first SMM entry point. */
-	if (size <= SMM_ENTRY_OFFSET)
+	/* Fail if can't parse the smm stub rmodule. */
+	if (rmodule_parse(&_binary_smmstub_start, &smm_stub))
 		return -1;
 
 	/* Need a minimum stack size and alignment. */
@@ -205,47 +264,18 @@ static int smm_module_setup_stub(void *smbase, struct smm_loader_params *params)
 	    (params->per_cpu_stack_size & 3) != 0)
 		return -1;
 
-	smm_stub_loc = NULL;
-	smm_stub_size = rmodule_memory_size(&smm_stub);
-	stub_entry_offset = rmodule_entry_offset(&smm_stub);
-
-	/* Assume the stub is always small enough to live within upper half of
-	 * SMRAM region after the save state space has been allocated. */
-	smm_stub_loc = &base[SMM_ENTRY_OFFSET];
-
-	/* Adjust for jmp instruction sequence. */
-	if (stub_entry_offset != 0) {
-		int entry_sequence_size = sizeof(struct smm_entry_ins);
-		/* Align up to 16 bytes. */
-		entry_sequence_size += 15;
-		entry_sequence_size &= ~15;
-		smm_stub_loc += entry_sequence_size;
-		smm_stub_size += entry_sequence_size;
-	}
-
-	/* Stub is too big to fit. */
-	if (smm_stub_size > (size - SMM_ENTRY_OFFSET))
+	if (smm_stub_compute_layout(base, params, &smm_stub, &layout))
 		return -1;
 
-	/* The stacks, if requested, live in the lower half of SMRAM space. */
-	size = SMM_ENTRY_OFFSET;
-
-	/* Ensure stacks don't encroach onto staggered SMM
-	 * entry points. The staggered entry points extend
-	 * below SMM_ENTRY_OFFSET by the number of concurrent
-	 * save states - 1 and save state size. */
-	if (params->num_concurrent_save_states > 1) {
-		size -= total_save_state_size;
-		size += params->per_cpu_save_state_size;
-	}
-
-	/* Place the stacks in the lower half of SMRAM. */
-	stacks_top = smm_stub_place_stacks(base, size, params);
+	/* The stacks, if requested, live in the lower half of SMRAM space
+	 * below the staggered SMM entry points. */
+	stacks_top = smm_stub_place_stacks(base, layout.entry_bottom - base,
+					   params);
 	if (stacks_top == NULL)
 		return -1;
 
 	/* Load the stub. */
-	if (rmodule_load(smm_stub_loc, &smm_stub))
+	if (rmodule_load(layout.stub, &smm_stub))
 		return -1;
 
 	/* Place staggered entry points. */
@@ -268,7 +298,7 @@ static int smm_module_setup_stub(void *smbase, struct smm_loader_params *params)
 	params->runtime = &stub_params->runtime;
 
 	printk(BIOS_DEBUG, "SMM Module: stub loaded at %p. Will call %p(%p)\n",
-	       smm_stub_loc, params->handler, params->handler_arg);
+	       layout.stub, params->handler, params->handler_arg);
 
 	return 0;
 }
@@ -325,6 +355,7 @@ int smm_load_module(void *smram, int size, struct smm_loader_params *params)
 	int module_alignment;
 	int alignment_size;
 	char *base;
+	int i;
 
 	if (size <= SMM_DEFAULT_SIZE)
 		return -1;
@@ -363,5 +394,23 @@ int smm_load_module(void *smram, int size, struct smm_loader_params *params)
 	params->handler = rmodule_entry(&smm_mod);
 	params->handler_arg = rmodule_parameters(&smm_mod);
 
-	return smm_module_setup_stub(smram, params);
+	if (smm_module_setup_stub(smram, params))
+		return -1;
+
+	/* Each CPU's SMBASE is one save state size below the previous one. */
+	num_cpu_smbases = MIN(params->num_concurrent_save_states,
+			      CONFIG_MAX_CPUS);
+	for (i = 0; i < num_cpu_smbases; i++)
+		cpu_smbase[i] = (uintptr_t)smram -
+				i * params->per_cpu_save_state_size;
+
+	return 0;
+}
+
+uintptr_t smm_get_cpu_smbase(int cpu)
+{
+	if (cpu < 0 || cpu >= num_cpu_smbases)
+		return 0;
+
+	return cpu_smbase[cpu];
 }
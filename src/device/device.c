@@ -46,9 +46,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <smp/spinlock.h>
+#include <span.h>
 #if CONFIG_ARCH_X86
 #include <arch/ebda.h>
 #endif
+#include <thread.h>
 #include <timer.h>
 
 /** Linked list of ALL devices */
@@ -245,61 +247,200 @@ static void read_resources(struct bus *bus)
 	       dev_path(bus->dev), bus->secondary, bus->link_num);
 }
 
-struct pick_largest_state {
-	struct resource *last;
-	struct device *result_dev;
-	struct resource *result;
-	int seen_last;
+/*
+ * Resources of a bus in the order the allocator hands out address space:
+ * largest alignment first, then largest size. Resources comparing equal stay
+ * in the order search_bus_resources() finds them in.
+ */
+struct sorted_resource {
+	struct device *dev;
+	struct resource *res;
+};
+
+struct sorted_resources {
+	struct sorted_resource *entries;
+	struct sorted_resource *scratch;
+	size_t count;
+	size_t capacity;
+	struct bus *bus;
+	struct resource *bridge;
 };
 
-static void pick_largest_resource(void *gp, struct device *dev,
-				  struct resource *resource)
+/*
+ * The list is filled and consumed completely before compute_resources()
+ * returns and before allocate_resources() recurses, so one buffer can be
+ * shared by all buses. It only ever grows.
+ */
+static struct sorted_resources sorted;
+
+/* Number of resources sorted since the last call to sorted_resources_total. */
+static size_t sorted_total;
+
+/*
+ * A domain may declare a prefetchable memory window above 4GiB by adding a
+ * resource with IORESOURCE_MEM | IORESOURCE_PREFETCH | IORESOURCE_PCI64.
+ * Prefetchable 64-bit resources that can live above 4GiB are then allocated
+ * from that window instead of the one below 4GiB. Ordinary 64-bit
+ * prefetchable BARs carry the same flags, so only resources of a domain
+ * count as the window.
+ */
+static int resource_is_mem64_window(const struct device *dev,
+				    const struct resource *res)
 {
-	struct pick_largest_state *state = gp;
-	struct resource *last;
+	const unsigned long mask = IORESOURCE_TYPE_MASK | IORESOURCE_PREFETCH |
+		IORESOURCE_PCI64 | IORESOURCE_BRIDGE | IORESOURCE_FIXED;
 
-	last = state->last;
+	if (dev->path.type != DEVICE_PATH_DOMAIN)
+		return 0;
 
-	/* Be certain to pick the successor to last. */
-	if (resource == last) {
-		state->seen_last = 1;
-		return;
+	return (res->flags & mask) ==
+		(IORESOURCE_MEM | IORESOURCE_PREFETCH | IORESOURCE_PCI64);
+}
+
+static int domain_has_mem64_window(struct device *dev)
+{
+	struct resource *res;
+
+	for (res = dev->resource_list; res; res = res->next) {
+		if (resource_is_mem64_window(dev, res))
+			return 1;
 	}
+	return 0;
+}
+
+static int resource_wants_mem64(const struct resource *res)
+{
+	return (res->flags & IORESOURCE_PREFETCH) &&
+	       (res->flags & IORESOURCE_PCI64) && res->limit > 0xffffffffULL;
+}
+
+/*
+ * Does the address space described by bridge take res? Only the windows of a
+ * domain with a memory window above 4GiB split their resources, everything
+ * else takes whatever matches the type.
+ */
+static int window_takes_resource(struct bus *bus, struct resource *bridge,
+				 struct resource *res)
+{
+	if (bridge->flags & IORESOURCE_BRIDGE)
+		return 1;
+	if (resource_is_mem64_window(bus->dev, bridge))
+		return resource_wants_mem64(res);
+	if ((bridge->flags & IORESOURCE_MEM) && domain_has_mem64_window(bus->dev))
+		return !resource_wants_mem64(res);
+	return 1;
+}
+
+static void count_resource(void *gp, struct device *dev,
+			   struct resource *resource)
+{
+	struct sorted_resources *list = gp;
+
 	if (resource->flags & IORESOURCE_FIXED)
-		return;	/* Skip it. */
-	if (last && ((last->align < resource->align) ||
-		     ((last->align == resource->align) &&
-		      (last->size < resource->size)) ||
-		     ((last->align == resource->align) &&
-		      (last->size == resource->size) && (!state->seen_last)))) {
 		return;
+
+	list->count++;
+}
+
+static void add_resource(void *gp, struct device *dev,
+			 struct resource *resource)
+{
+	struct sorted_resources *list = gp;
+
+	if (resource->flags & IORESOURCE_FIXED)
+		return;
+	if (!window_takes_resource(list->bus, list->bridge, resource))
+		return;
+
+	list->entries[list->count].dev = dev;
+	list->entries[list->count].res = resource;
+	list->count++;
+}
+
+/* Does a have to be placed before b? */
+static int resource_goes_first(const struct resource *a,
+			       const struct resource *b)
+{
+	if (a->align != b->align)
+		return a->align > b->align;
+	return a->size > b->size;
+}
+
+/* Stable bottom-up merge sort, there is no qsort() and it wouldn't be stable. */
+static void sort_resources(struct sorted_resources *list)
+{
+	struct sorted_resource *src = list->entries;
+	struct sorted_resource *dst = list->scratch;
+	struct sorted_resource *tmp;
+	size_t n = list->count;
+	size_t width, lo, mid, hi, i, j, k;
+
+	for (width = 1; width < n; width *= 2) {
+		for (lo = 0; lo < n; lo += 2 * width) {
+			mid = MIN(lo + width, n);
+			hi = MIN(lo + 2 * width, n);
+			i = lo;
+			j = mid;
+			for (k = lo; k < hi; k++) {
+				if (i < mid && (j >= hi ||
+				    !resource_goes_first(src[j].res,
+							 src[i].res)))
+					dst[k] = src[i++];
+				else
+					dst[k] = src[j++];
+			}
+		}
+		tmp = src;
+		src = dst;
+		dst = tmp;
 	}
-	if (!state->result ||
-	    (state->result->align < resource->align) ||
-	    ((state->result->align == resource->align) &&
-	     (state->result->size < resource->size))) {
-		state->result_dev = dev;
-		state->result = resource;
-	}
+
+	if (src != list->entries)
+		memcpy(list->entries, src, n * sizeof(*src));
 }
 
-static struct device *largest_resource(struct bus *bus,
-				       struct resource **result_res,
-				       unsigned long type_mask,
-				       unsigned long type)
+/*
+ * Collect the unfixed resources of the given type on bus that belong into
+ * bridge and sort them. Walking the bus once replaces searching it for the
+ * next largest resource over and over, which is quadratic in the number of
+ * resources behind a bridge.
+ */
+static struct sorted_resources *sort_bus_resources(struct bus *bus,
+						   struct resource *bridge,
+						   unsigned long type_mask,
+						   unsigned long type)
 {
-	struct pick_largest_state state;
+	struct sorted_resources *list = &sorted;
+
+	list->count = 0;
+	search_bus_resources(bus, type_mask, type, count_resource, list);
+
+	if (list->count > list->capacity) {
+		/* Grow geometrically, the heap may not be able to free. */
+		list->capacity = MAX(list->count, 2 * list->capacity);
+		free(list->entries);
+		free(list->scratch);
+		list->entries = malloc(list->capacity * sizeof(*list->entries));
+		list->scratch = malloc(list->capacity * sizeof(*list->scratch));
+	}
 
-	state.last = *result_res;
-	state.result_dev = NULL;
-	state.result = NULL;
-	state.seen_last = 0;
+	list->count = 0;
+	list->bus = bus;
+	list->bridge = bridge;
+	search_bus_resources(bus, type_mask, type, add_resource, list);
+
+	sort_resources(list);
+	sorted_total += list->count;
+
+	return list;
+}
 
-	search_bus_resources(bus, type_mask, type, pick_largest_resource,
-			     &state);
+static size_t sorted_resources_total(void)
+{
+	size_t total = sorted_total;
 
-	*result_res = state.result;
-	return state.result_dev;
+	sorted_total = 0;
+	return total;
 }
 
 /**
@@ -338,9 +479,11 @@ static struct device *largest_resource(struct bus *bus,
 static void compute_resources(struct bus *bus, struct resource *bridge,
 			      unsigned long type_mask, unsigned long type)
 {
+	struct sorted_resources *list;
 	struct device *dev;
 	struct resource *resource;
 	resource_t base;
+	size_t i;
 	base = round(bridge->base, bridge->align);
 
 	printk(BIOS_SPEW,  "%s %s: base: %llx size: %llx align: %d gran: %d"
@@ -361,7 +504,8 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 			struct bus* link;
 
 			if (!(child_bridge->flags & IORESOURCE_BRIDGE)
-			    || (child_bridge->flags & type_mask) != type)
+			    || (child_bridge->flags & type_mask) != type
+			    || !window_takes_resource(bus, bridge, child_bridge))
 				continue;
 
 			/*
@@ -389,15 +533,15 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 		}
 	}
 
-	/* Remember we haven't found anything yet. */
-	resource = NULL;
-
 	/*
 	 * Walk through all the resources on the current bus and compute the
 	 * amount of address space taken by them. Take granularity and
 	 * alignment into account.
 	 */
-	while ((dev = largest_resource(bus, &resource, type_mask, type))) {
+	list = sort_bus_resources(bus, bridge, type_mask, type);
+	for (i = 0; i < list->count; i++) {
+		dev = list->entries[i].dev;
+		resource = list->entries[i].res;
 
 		/* Size 0 resources can be skipped. */
 		if (!resource->size)
@@ -482,9 +626,11 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 static void allocate_resources(struct bus *bus, struct resource *bridge,
 			       unsigned long type_mask, unsigned long type)
 {
+	struct sorted_resources *list;
 	struct device *dev;
 	struct resource *resource;
 	resource_t base;
+	size_t i;
 	base = bridge->base;
 
 	printk(BIOS_SPEW, "%s %s: base:%llx size:%llx align:%d gran:%d "
@@ -492,14 +638,14 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 	       resource2str(bridge),
 	       base, bridge->size, bridge->align, bridge->gran, bridge->limit);
 
-	/* Remember we haven't found anything yet. */
-	resource = NULL;
-
 	/*
 	 * Walk through all the resources on the current bus and allocate them
 	 * address space.
 	 */
-	while ((dev = largest_resource(bus, &resource, type_mask, type))) {
+	list = sort_bus_resources(bus, bridge, type_mask, type);
+	for (i = 0; i < list->count; i++) {
+		dev = list->entries[i].dev;
+		resource = list->entries[i].res;
 
 		/* Propagate the bridge limit to the resource register. */
 		if (resource->limit > bridge->limit)
@@ -591,7 +737,8 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 			struct bus* link;
 
 			if (!(child_bridge->flags & IORESOURCE_BRIDGE) ||
-			    (child_bridge->flags & type_mask) != type)
+			    (child_bridge->flags & type_mask) != type ||
+			    !window_takes_resource(bus, bridge, child_bridge))
 				continue;
 
 			/*
@@ -624,15 +771,18 @@ static int resource_is(struct resource *res, u32 type)
 }
 
 struct constraints {
-	struct resource io, mem;
+	struct resource io, mem, mem64;
 };
 
-static struct resource * resource_limit(struct constraints *limits, struct resource *res)
+static struct resource * resource_limit(struct constraints *limits,
+					struct device *dev, struct resource *res)
 {
 	struct resource *lim = NULL;
 
 	/* MEM, or I/O - skip any others. */
-	if (resource_is(res, IORESOURCE_MEM))
+	if (resource_is_mem64_window(dev, res))
+		lim = &limits->mem64;
+	else if (resource_is(res, IORESOURCE_MEM))
 		lim = &limits->mem;
 	else if (resource_is(res, IORESOURCE_IO))
 		lim = &limits->io;
@@ -640,6 +790,34 @@ static struct resource * resource_limit(struct constraints *limits, struct resou
 	return lim;
 }
 
+static void constrain_limit(struct device *dev, struct resource *lim,
+			    struct resource *res)
+{
+	/*
+	 * Is it a fixed resource outside the current known region?
+	 * If so, we don't have to consider it - it will be handled
+	 * correctly and doesn't affect current region's limits.
+	 */
+	if (((res->base + res->size -1) < lim->base)
+	    || (res->base > lim->limit))
+		return;
+
+	printk(BIOS_SPEW, "%s: %s %02lx base %08llx limit %08llx %s (fixed)\n",
+		__func__, dev_path(dev), res->index, res->base,
+		res->base + res->size - 1, resource2str(res));
+
+	/*
+	 * Choose to be above or below fixed resources. This check is
+	 * signed so that "negative" amounts of space are handled
+	 * correctly.
+	 */
+	if ((signed long long)(lim->limit - (res->base + res->size -1))
+	    > (signed long long)(res->base - lim->base))
+		lim->base = res->base + res->size;
+	else
+		lim->limit = res->base -1;
+}
+
 static void constrain_resources(struct device *dev, struct constraints* limits)
 {
 	struct device *child;
@@ -658,33 +836,15 @@ static void constrain_resources(struct device *dev, struct constraints* limits)
 			continue;
 		}
 
-		lim = resource_limit(limits, res);
+		lim = resource_limit(limits, dev, res);
 		if (!lim)
 			continue;
 
-		/*
-		 * Is it a fixed resource outside the current known region?
-		 * If so, we don't have to consider it - it will be handled
-		 * correctly and doesn't affect current region's limits.
-		 */
-		if (((res->base + res->size -1) < lim->base)
-		    || (res->base > lim->limit))
-			continue;
-
-		printk(BIOS_SPEW, "%s: %s %02lx base %08llx limit %08llx %s (fixed)\n",
-			__func__, dev_path(dev), res->index, res->base,
-			res->base + res->size - 1, resource2str(res));
+		constrain_limit(dev, lim, res);
 
-		/*
-		 * Choose to be above or below fixed resources. This check is
-		 * signed so that "negative" amounts of space are handled
-		 * correctly.
-		 */
-		if ((signed long long)(lim->limit - (res->base + res->size -1))
-		    > (signed long long)(res->base - lim->base))
-			lim->base = res->base + res->size;
-		else
-			lim->limit = res->base -1;
+		/* Fixed memory also has to stay out of the window above 4GiB. */
+		if (lim == &limits->mem)
+			constrain_limit(dev, &limits->mem64, res);
 	}
 
 	/* Descend into every enabled child and look for fixed resources. */
@@ -709,6 +869,8 @@ static void avoid_fixed_resources(struct device *dev)
 	limits.io.limit = 0xffffffffffffffffULL;
 	limits.mem.base = 0;
 	limits.mem.limit = 0xffffffffffffffffULL;
+	limits.mem64.base = 0;
+	limits.mem64.limit = 0xffffffffffffffffULL;
 
 	/* Constrain the limits to dev's initial resources. */
 	for (res = dev->resource_list; res; res = res->next) {
@@ -717,7 +879,7 @@ static void avoid_fixed_resources(struct device *dev)
 		printk(BIOS_SPEW, "%s:@%s %02lx limit %08llx\n", __func__,
 		       dev_path(dev), res->index, res->limit);
 
-		lim = resource_limit(&limits, res);
+		lim = resource_limit(&limits, dev, res);
 		if (!lim)
 			continue;
 
@@ -735,7 +897,7 @@ static void avoid_fixed_resources(struct device *dev)
 		if ((res->flags & IORESOURCE_FIXED))
 			continue;
 
-		lim = resource_limit(&limits, res);
+		lim = resource_limit(&limits, dev, res);
 		if (!lim)
 			continue;
 
@@ -1021,6 +1183,8 @@ void dev_configure(void)
 	struct resource *res;
 	struct device *root;
 	struct device *child;
+	struct stopwatch sw;
+	int pass;
 
 	set_vga_bridge_bits();
 
@@ -1047,20 +1211,34 @@ void dev_configure(void)
 		if (!(child->path.type == DEVICE_PATH_DOMAIN))
 			continue;
 		post_log_path(child);
-		for (res = child->resource_list; res; res = res->next) {
-			if (res->flags & IORESOURCE_FIXED)
-				continue;
-			if (res->flags & IORESOURCE_MEM) {
-				compute_resources(child->link_list,
-						  res, IORESOURCE_TYPE_MASK, IORESOURCE_MEM);
-				continue;
-			}
-			if (res->flags & IORESOURCE_IO) {
-				compute_resources(child->link_list,
-						  res, IORESOURCE_TYPE_MASK, IORESOURCE_IO);
-				continue;
+		stopwatch_init(&sw);
+		for (pass = 0; pass < 2; pass++) {
+			for (res = child->resource_list; res; res = res->next) {
+				if (res->flags & IORESOURCE_FIXED)
+					continue;
+				/*
+				 * Size the window above 4GiB first. Bridges
+				 * that turn out to need a window below 4GiB
+				 * are then picked up by the second pass.
+				 */
+				if (resource_is_mem64_window(child, res) !=
+				    (pass == 0))
+					continue;
+				if (res->flags & IORESOURCE_MEM) {
+					compute_resources(child->link_list,
+							  res, IORESOURCE_TYPE_MASK, IORESOURCE_MEM);
+					continue;
+				}
+				if (res->flags & IORESOURCE_IO) {
+					compute_resources(child->link_list,
+							  res, IORESOURCE_TYPE_MASK, IORESOURCE_IO);
+					continue;
+				}
 			}
 		}
+		printk(BIOS_DEBUG, "%s: computed %zu resources in %ld usecs\n",
+		       dev_path(child), sorted_resources_total(),
+		       stopwatch_duration_usecs(&sw));
 	}
 
 	/* For all domains. */
@@ -1074,6 +1252,7 @@ void dev_configure(void)
 		if (!(child->path.type == DEVICE_PATH_DOMAIN))
 			continue;
 		post_log_path(child);
+		stopwatch_init(&sw);
 		for (res = child->resource_list; res; res = res->next) {
 			if (res->flags & IORESOURCE_FIXED)
 				continue;
@@ -1088,6 +1267,9 @@ void dev_configure(void)
 				continue;
 			}
 		}
+		printk(BIOS_DEBUG, "%s: allocated %zu resources in %ld usecs\n",
+		       dev_path(child), sorted_resources_total(),
+		       stopwatch_duration_usecs(&sw));
 	}
 	assign_resources(root->link_list);
 	printk(BIOS_INFO, "Done setting resources.\n");
@@ -1140,8 +1322,16 @@ static void init_dev(struct device *dev)
 		}
 
 		printk(BIOS_DEBUG, "%s init ...\n", dev_path(dev));
+		/*
+		 * Asynchronous inits interleave with the rest of the boot and
+		 * would break the nesting of spans, so they are not recorded.
+		 */
+		if (!dev->ops->init_async)
+			span_begin(dev_path(dev));
 		dev->initialized = 1;
 		dev->ops->init(dev);
+		if (!dev->ops->init_async)
+			span_end(dev_path(dev));
 #if CONFIG_HAVE_MONOTONIC_TIMER
 		printk(BIOS_DEBUG, "%s init finished in %ld usecs\n", dev_path(dev),
 			stopwatch_duration_usecs(&sw));
@@ -1166,6 +1356,228 @@ static void init_link(struct bus *link)
 	}
 }
 
+#if IS_ENABLED(CONFIG_ASYNC_DEVICE_INIT)
+
+enum {
+	DEV_INIT_PENDING = 0,
+	DEV_INIT_RUNNING,
+	DEV_INIT_DONE,
+};
+
+/* How long the main thread sleeps while waiting for asynchronous inits. */
+#define DEV_INIT_POLL_USECS 100
+
+struct init_pass {
+	/* Number of devices that are not done yet. */
+	int pending;
+	/* Set if any device was started during this pass. */
+	int progress;
+	/* Set once a synchronous init had to wait. */
+	int sync_blocked;
+	/* Set when dependencies turned out to be unsatisfiable. */
+	int ignore_deps;
+};
+
+static struct stopwatch init_sw;
+static struct device *last_sync_dev;
+static int async_inits_running;
+
+void dev_init_depends_on(struct device *dev, struct device *dep)
+{
+	int i;
+
+	for (i = 0; i < DEVICE_MAX_INIT_DEPS; i++) {
+		if (dev->init_deps[i] == dep)
+			return;
+		if (dev->init_deps[i] == NULL) {
+			dev->init_deps[i] = dep;
+			return;
+		}
+	}
+
+	printk(BIOS_ERR, "%s: too many init dependencies, dropping %s\n",
+	       dev_path(dev), dev_path(dep));
+}
+
+static void init_dev_timed(struct device *dev)
+{
+	dev->init_start = stopwatch_duration_usecs(&init_sw);
+	init_dev(dev);
+	dev->init_finish = stopwatch_duration_usecs(&init_sw);
+	dev->init_state = DEV_INIT_DONE;
+}
+
+static void init_dev_thread(void *arg)
+{
+	init_dev_timed(arg);
+	async_inits_running--;
+}
+
+/* Account for dep and remember it if it finished later than *latest. */
+static int init_dep_done(struct device *dep, struct device **latest)
+{
+	if (dep->init_state != DEV_INIT_DONE)
+		return 0;
+
+	if (*latest == NULL || dep->init_finish > (*latest)->init_finish)
+		*latest = dep;
+
+	return 1;
+}
+
+static int init_deps_done(struct device *dev, struct device **latest)
+{
+	struct device *parent = dev->bus ? dev->bus->dev : NULL;
+	int done = 1;
+	int i;
+
+	if (parent != NULL && parent != dev)
+		done &= init_dep_done(parent, latest);
+
+	for (i = 0; i < DEVICE_MAX_INIT_DEPS && dev->init_deps[i]; i++)
+		done &= init_dep_done(dev->init_deps[i], latest);
+
+	return done;
+}
+
+static void start_dev_init(struct device *dev, struct init_pass *pass)
+{
+	struct device *latest = NULL;
+	int has_init;
+	int async;
+
+	if (dev->init_state == DEV_INIT_DONE)
+		return;
+
+	pass->pending++;
+
+	if (dev->init_state == DEV_INIT_RUNNING)
+		return;
+
+	has_init = dev->enabled && dev->ops && dev->ops->init;
+	async = has_init && dev->ops->init_async;
+
+	/* Synchronous inits still happen in tree order. */
+	if (has_init && !async && pass->sync_blocked)
+		return;
+
+	if (!init_deps_done(dev, &latest) && !pass->ignore_deps) {
+		if (has_init && !async)
+			pass->sync_blocked = 1;
+		return;
+	}
+
+	if (has_init && !async) {
+		if (last_sync_dev != NULL && (latest == NULL ||
+		    last_sync_dev->init_finish > latest->init_finish))
+			latest = last_sync_dev;
+		last_sync_dev = dev;
+	}
+
+	dev->init_critical = latest;
+	pass->progress = 1;
+	pass->pending--;
+
+	post_code(POST_BS_DEV_INIT);
+	post_log_path(dev);
+
+	if (async && async_inits_running < CONFIG_NUM_THREADS - 1) {
+		dev->init_state = DEV_INIT_RUNNING;
+		async_inits_running++;
+		if (thread_run(init_dev_thread, dev) == 0)
+			return;
+		async_inits_running--;
+	}
+
+	init_dev_timed(dev);
+}
+
+static void start_link_inits(struct bus *link, struct init_pass *pass)
+{
+	struct device *dev;
+	struct bus *c_link;
+
+	for (dev = link->children; dev; dev = dev->sibling)
+		start_dev_init(dev, pass);
+
+	for (dev = link->children; dev; dev = dev->sibling) {
+		for (c_link = dev->link_list; c_link; c_link = c_link->next)
+			start_link_inits(c_link, pass);
+	}
+}
+
+static void report_init_critical_path(void)
+{
+	struct device *dev;
+	struct device *last = NULL;
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		if (dev->init_state != DEV_INIT_DONE)
+			continue;
+		if (last == NULL || dev->init_finish > last->init_finish)
+			last = dev;
+	}
+
+	if (last == NULL)
+		return;
+
+	printk(BIOS_DEBUG, "Device init took %ld usecs, critical path:\n",
+	       last->init_finish);
+	for (dev = last; dev; dev = dev->init_critical)
+		printk(BIOS_DEBUG, "  %s: %ld - %ld usecs (%ld usecs)\n",
+		       dev_path(dev), dev->init_start, dev->init_finish,
+		       dev->init_finish - dev->init_start);
+}
+
+/*
+ * Keep walking the tree in init order, starting every device whose
+ * dependencies are done, until all are done. The main thread sleeps while
+ * nothing can be started, which lets the asynchronous inits progress.
+ */
+static void init_devices_async(void)
+{
+	struct init_pass pass;
+	struct device *dev;
+	struct bus *link;
+	int ignore_deps = 0;
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		if (dev->enabled && dev->ops && dev->ops->init_dependencies)
+			dev->ops->init_dependencies(dev);
+	}
+
+	stopwatch_init(&init_sw);
+
+	do {
+		memset(&pass, 0, sizeof(pass));
+		pass.ignore_deps = ignore_deps;
+
+		/* The mainboard init comes first, everything depends on it. */
+		start_dev_init(&dev_root, &pass);
+		for (link = dev_root.link_list; link; link = link->next)
+			start_link_inits(link, &pass);
+
+		if (pass.progress || !pass.pending)
+			continue;
+
+		if (async_inits_running) {
+			thread_yield_microseconds(DEV_INIT_POLL_USECS);
+		} else {
+			printk(BIOS_ERR, "Device init dependencies can't be "
+			       "met, ignoring them\n");
+			ignore_deps = 1;
+		}
+	} while (pass.pending);
+
+	report_init_critical_path();
+}
+
+#else
+
+static inline void init_devices_async(void) {}
+
+#endif /* CONFIG_ASYNC_DEVICE_INIT */
+
 /**
  * Initialize all devices in the global device tree.
  *
@@ -1183,12 +1595,16 @@ void dev_initialize(void)
 	setup_default_ebda();
 #endif
 
-	/* First call the mainboard init. */
-	init_dev(&dev_root);
+	if (IS_ENABLED(CONFIG_ASYNC_DEVICE_INIT)) {
+		init_devices_async();
+	} else {
+		/* First call the mainboard init. */
+		init_dev(&dev_root);
 
-	/* Now initialize everything. */
-	for (link = dev_root.link_list; link; link = link->next)
-		init_link(link);
+		/* Now initialize everything. */
+		for (link = dev_root.link_list; link; link = link->next)
+			init_link(link);
+	}
 	post_log_clear();
 
 	printk(BIOS_INFO, "Devices initialized\n");
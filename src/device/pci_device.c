@@ -49,6 +49,10 @@
 #include <pc80/i8259.h>
 #include <kconfig.h>
 #include <vboot/vbnv.h>
+#if IS_ENABLED(CONFIG_PCI_PARALLEL_ROOT_PROBE)
+#include <arch/pci_ops.h>
+#include <cpu/x86/mp.h>
+#endif
 
 u8 pci_moving_config8(struct device *dev, unsigned int reg)
 {
@@ -86,19 +90,11 @@ u16 pci_moving_config16(struct device *dev, unsigned int reg)
 
 u32 pci_moving_config32(struct device *dev, unsigned int reg)
 {
-	u32 value, ones, zeroes;
-
-	value = pci_read_config32(dev, reg);
-
-	pci_write_config32(dev, reg, 0xffffffff);
-	ones = pci_read_config32(dev, reg);
+	u32 value, moving;
 
-	pci_write_config32(dev, reg, 0x00000000);
-	zeroes = pci_read_config32(dev, reg);
+	pci_moving_config32_block(dev, reg, &value, &moving, 1);
 
-	pci_write_config32(dev, reg, value);
-
-	return ones ^ zeroes;
+	return moving;
 }
 
 /**
@@ -168,27 +164,24 @@ unsigned pci_find_capability(device_t dev, unsigned cap)
 	return pci_find_next_capability(dev, cap, 0);
 }
 
-/**
- * Given a device and register, read the size of the BAR for that register.
- *
- * @param dev Pointer to the device structure.
- * @param index Address of the PCI configuration register.
- * @return TODO
+/*
+ * Set up the resource for the BAR at index from its initial value and the
+ * bits that move. For a 64-bit BAR the high half is taken from moving_hi,
+ * or sized here if that is NULL.
  */
-struct resource *pci_get_resource(struct device *dev, unsigned long index)
+static struct resource *pci_bar_resource(struct device *dev,
+					 unsigned long index,
+					 unsigned long value, u32 moving_lo,
+					 const u32 *moving_hi)
 {
 	struct resource *resource;
-	unsigned long value, attr;
+	unsigned long attr;
 	resource_t moving, limit;
 
 	/* Initialize the resources to nothing. */
 	resource = new_resource(dev, index);
 
-	/* Get the initial value. */
-	value = pci_read_config32(dev, index);
-
-	/* See which bits move. */
-	moving = pci_moving_config32(dev, index);
+	moving = moving_lo;
 
 	/* Initialize attr to the bits that do not move. */
 	attr = value & ~moving;
@@ -198,8 +191,11 @@ struct resource *pci_get_resource(struct device *dev, unsigned long index)
 	    ((attr & PCI_BASE_ADDRESS_MEM_LIMIT_MASK) ==
 	     PCI_BASE_ADDRESS_MEM_LIMIT_64)) {
 		/* Find the high bits that move. */
-		moving |=
-		    ((resource_t) pci_moving_config32(dev, index + 4)) << 32;
+		if (moving_hi == NULL)
+			moving |= ((resource_t)
+				   pci_moving_config32(dev, index + 4)) << 32;
+		else
+			moving |= ((resource_t) *moving_hi) << 32;
 	}
 
 	/* Find the resource constraints.
@@ -286,6 +282,23 @@ struct resource *pci_get_resource(struct device *dev, unsigned long index)
 	return resource;
 }
 
+/**
+ * Given a device and register, read the size of the BAR for that register.
+ *
+ * @param dev Pointer to the device structure.
+ * @param index Address of the PCI configuration register.
+ * @return Pointer to the resource of the BAR.
+ */
+struct resource *pci_get_resource(struct device *dev, unsigned long index)
+{
+	u32 value, moving;
+
+	/* Get the initial value and see which bits move. */
+	pci_moving_config32_block(dev, index, &value, &moving, 1);
+
+	return pci_bar_resource(dev, index, value, moving, NULL);
+}
+
 /**
  * Given a device and an index, read the size of the BAR for that register.
  *
@@ -295,17 +308,13 @@ struct resource *pci_get_resource(struct device *dev, unsigned long index)
 static void pci_get_rom_resource(struct device *dev, unsigned long index)
 {
 	struct resource *resource;
-	unsigned long value;
-	resource_t moving;
+	u32 value, moving;
 
 	/* Initialize the resources to nothing. */
 	resource = new_resource(dev, index);
 
-	/* Get the initial value. */
-	value = pci_read_config32(dev, index);
-
-	/* See which bits move. */
-	moving = pci_moving_config32(dev, index);
+	/* Get the initial value and see which bits move. */
+	pci_moving_config32_block(dev, index, &value, &moving, 1);
 
 	/* Clear the Enable bit. */
 	moving = moving & ~PCI_ROM_ADDRESS_ENABLE;
@@ -328,7 +337,7 @@ static void pci_get_rom_resource(struct device *dev, unsigned long index)
 		resource->flags |= IORESOURCE_MEM | IORESOURCE_READONLY;
 	} else {
 		if (value != 0) {
-			printk(BIOS_DEBUG, "%s register %02lx(%08lx), "
+			printk(BIOS_DEBUG, "%s register %02lx(%08x), "
 			       "read-only ignoring it\n",
 			       dev_path(dev), index, value);
 		}
@@ -345,13 +354,20 @@ static void pci_get_rom_resource(struct device *dev, unsigned long index)
  */
 static void pci_read_bases(struct device *dev, unsigned int howmany)
 {
-	unsigned long index;
+	u32 value[6], moving[6];
+	unsigned int i;
+
+	/* Size all BARs in one go, the high half of 64-bit BARs included. */
+	pci_moving_config32_block(dev, PCI_BASE_ADDRESS_0, value, moving,
+				  howmany);
 
-	for (index = PCI_BASE_ADDRESS_0;
-	     (index < PCI_BASE_ADDRESS_0 + (howmany << 2));) {
+	for (i = 0; i < howmany;) {
 		struct resource *resource;
-		resource = pci_get_resource(dev, index);
-		index += (resource->flags & IORESOURCE_PCI64) ? 8 : 4;
+		resource = pci_bar_resource(dev, PCI_BASE_ADDRESS_0 + (i << 2),
+					    value[i], moving[i],
+					    i + 1 < howmany ? &moving[i + 1] :
+					    NULL);
+		i += (resource->flags & IORESOURCE_PCI64) ? 2 : 1;
 	}
 
 	compact_resources(dev);
@@ -417,7 +433,8 @@ static void pci_bridge_read_bases(struct device *dev)
 	moving = moving_base & moving_limit;
 	/* Initialize the prefetchable memory constraints on the current bus. */
 	pci_record_bridge_resource(dev, moving, PCI_PREF_MEMORY_BASE,
-				   IORESOURCE_MEM | IORESOURCE_PREFETCH);
+				   IORESOURCE_MEM | IORESOURCE_PREFETCH |
+				   ((moving >> 32) ? IORESOURCE_PCI64 : 0));
 
 	/* See if the bridge mem resources are implemented. */
 	moving_base = ((u32) pci_moving_config16(dev, PCI_MEMORY_BASE)) << 16;
@@ -462,6 +479,27 @@ void pci_domain_read_resources(struct device *dev)
 		     IORESOURCE_ASSIGNED;
 }
 
+/*
+ * Give the domain a prefetchable memory window above 4GiB. 64-bit
+ * prefetchable BARs and bridge windows are allocated from it instead of the
+ * memory window below 4GiB. base and limit are inclusive and have to be
+ * kept clear of DRAM by the caller.
+ *
+ * No chipset calls this yet. Until one does from its domain's
+ * read_resources(), every BAR is still placed below 4GiB.
+ */
+void pci_domain_add_mem64_window(struct device *dev, resource_t base,
+				 resource_t limit)
+{
+	struct resource *res;
+
+	res = new_resource(dev, IOINDEX_SUBTRACTIVE(2, 0));
+	res->base = base;
+	res->limit = limit;
+	res->flags = IORESOURCE_MEM | IORESOURCE_PREFETCH | IORESOURCE_PCI64 |
+		     IORESOURCE_SUBTRACTIVE | IORESOURCE_ASSIGNED;
+}
+
 static void pci_set_resource(struct device *dev, struct resource *resource)
 {
 	resource_t base, end;
@@ -956,6 +994,13 @@ static struct device *pci_scan_get_dev(struct device **list, unsigned int devfn)
 	return dev;
 }
 
+static int pci_id_present(u32 id)
+{
+	/* Some broken boards return 0 if a slot is empty. */
+	return (id != 0xffffffff) && (id != 0x00000000) &&
+	       (id != 0x0000ffff) && (id != 0xffff0000);
+}
+
 /**
  * Scan a PCI bus.
  *
@@ -969,7 +1014,7 @@ static struct device *pci_scan_get_dev(struct device **list, unsigned int devfn)
  */
 device_t pci_probe_dev(device_t dev, struct bus *bus, unsigned devfn)
 {
-	u32 id, class;
+	u32 id, class, header[2];
 	u8 hdr_type;
 
 	/* Detect if a device is present. */
@@ -1021,8 +1066,7 @@ device_t pci_probe_dev(device_t dev, struct bus *bus, unsigned devfn)
 		 * show up.
 		 */
 		/* If the chain is fully enumerated quit */
-		if ((id == 0xffffffff) || (id == 0x00000000) ||
-		    (id == 0x0000ffff) || (id == 0xffff0000)) {
+		if (!pci_id_present(id)) {
 			if (dev->enabled) {
 				printk(BIOS_INFO, "PCI: Static device %s not "
 				       "found, disabling it.\n", dev_path(dev));
@@ -1032,9 +1076,14 @@ device_t pci_probe_dev(device_t dev, struct bus *bus, unsigned devfn)
 		}
 	}
 
-	/* Read the rest of the PCI configuration information. */
-	hdr_type = pci_read_config8(dev, PCI_HEADER_TYPE);
-	class = pci_read_config32(dev, PCI_CLASS_REVISION);
+	/*
+	 * Read the rest of the PCI configuration information. The header
+	 * type is in the dword following the class code.
+	 */
+	pci_read_config32_block(dev, PCI_CLASS_REVISION, header,
+				ARRAY_SIZE(header));
+	class = header[0];
+	hdr_type = (header[1] >> 16) & 0xff;
 
 	/* Store the interesting information in the device structure. */
 	dev->vendor = id & 0xffff;
@@ -1080,6 +1129,95 @@ unsigned int pci_match_simple_dev(device_t dev, pci_devfn_t sdev)
 			dev->path.pci.devfn == PCI_DEV2DEVFN(sdev);
 }
 
+#if IS_ENABLED(CONFIG_PCI_PARALLEL_ROOT_PROBE)
+/*
+ * Parallel probing of a root bus. Before the bus is scanned the BSP and all
+ * APs which accept jobs read the IDs of all functions on the bus, each CPU
+ * taking the next device number until none are left. Functions 1-7 are
+ * only read if function 0 is a multi-function device. pci_scan_bus() then
+ * skips the functions found absent here, unless they are in the
+ * devicetree. The IDs are only used for the next scan of that bus.
+ */
+static struct {
+	struct bus *bus;
+	u32 id[256];
+} root_probe;
+
+static void pci_root_probe_slot(void *arg, int slot)
+{
+	struct device dummy;
+	unsigned int func;
+
+	dummy.bus = root_probe.bus;
+	dummy.path.type = DEVICE_PATH_PCI;
+
+	for (func = 0; func < 8; func++) {
+		u32 id;
+
+		dummy.path.pci.devfn = PCI_DEVFN(slot, func);
+		id = pci_read_config32(&dummy, PCI_VENDOR_ID);
+		root_probe.id[dummy.path.pci.devfn] = id;
+
+		if (func == 0 && (!pci_id_present(id) ||
+		    !(pci_read_config8(&dummy, PCI_HEADER_TYPE) & 0x80)))
+			break;
+	}
+}
+
+/**
+ * Probe the functions on a root bus in parallel.
+ *
+ * Only done if there are APs to help and config space is accessed through
+ * MMCONF, CF8/CFC accesses from several CPUs would interfere. A chipset
+ * whose enable_dev() makes non-static devices appear on the same bus can't
+ * use this.
+ *
+ * All platforms currently bring up their APs in BS_DEV_INIT, after device
+ * enumeration, so there are no APs to help yet and this returns early.
+ *
+ * @param bus Pointer to the root bus, its bus number has to be set up.
+ */
+void pci_probe_root_bus(struct bus *bus)
+{
+	int num_cpus;
+
+	root_probe.bus = NULL;
+
+	if (bus->dev->ops->ops_pci_bus &&
+	    bus->dev->ops->ops_pci_bus(bus->dev) != &pci_ops_mmconf)
+		return;
+
+	if (mp_get_ap_count() == 0)
+		return;
+
+	memset(root_probe.id, 0xff, sizeof(root_probe.id));
+	root_probe.bus = bus;
+
+	num_cpus = mp_run_queue(pci_root_probe_slot, NULL, 32);
+
+	printk(BIOS_DEBUG, "PCI: Probed bus %02x on %d CPUs\n",
+	       bus->secondary, num_cpus);
+}
+
+static int pci_root_probe_absent(struct bus *bus, unsigned int devfn)
+{
+	return root_probe.bus == bus && !pci_id_present(root_probe.id[devfn]);
+}
+
+static void pci_root_probe_done(struct bus *bus)
+{
+	if (root_probe.bus == bus)
+		root_probe.bus = NULL;
+}
+#else
+static int pci_root_probe_absent(struct bus *bus, unsigned int devfn)
+{
+	return 0;
+}
+
+static void pci_root_probe_done(struct bus *bus) {}
+#endif
+
 /**
  * Scan a PCI bus.
  *
@@ -1123,7 +1261,8 @@ void pci_scan_bus(struct bus *bus, unsigned min_devfn,
 		dev = pci_scan_get_dev(&old_devices, devfn);
 
 		/* See if a device is present and setup the device structure. */
-		dev = pci_probe_dev(dev, bus, devfn);
+		if (dev || !pci_root_probe_absent(bus, devfn))
+			dev = pci_probe_dev(dev, bus, devfn);
 
 		/*
 		 * If this is not a multi function device, or the device is
@@ -1138,6 +1277,8 @@ void pci_scan_bus(struct bus *bus, unsigned min_devfn,
 
 	post_code(0x25);
 
+	pci_root_probe_done(bus);
+
 	/*
 	 * Warn if any leftover static devices are are found.
 	 * There's probably a problem in devicetree.cb.
@@ -1283,6 +1424,7 @@ void pci_scan_bridge(struct device *dev)
 void pci_domain_scan_bus(device_t dev)
 {
 	struct bus *link = dev->link_list;
+	pci_probe_root_bus(link);
 	pci_scan_bus(link, PCI_DEVFN(0, 0), 0xff);
 }
 
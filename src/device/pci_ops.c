@@ -119,6 +119,56 @@ void pci_write_config32(struct device *dev, unsigned int where, u32 val)
 				   dev->path.pci.devfn, where, val);
 }
 
+void pci_read_config32_block(struct device *dev, unsigned int where,
+			     u32 *buf, unsigned int count)
+{
+	struct bus *pbus = get_pbus(dev);
+	const struct pci_bus_operations *bops = pci_bus_ops(pbus, dev);
+	unsigned int i;
+
+	if (bops->read_block) {
+		bops->read_block(pbus, dev->bus->secondary,
+				 dev->path.pci.devfn, where, buf, count);
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		buf[i] = bops->read32(pbus, dev->bus->secondary,
+				      dev->path.pci.devfn, where + 4 * i);
+}
+
+void pci_moving_config32_block(struct device *dev, unsigned int where,
+			       u32 *value, u32 *moving, unsigned int count)
+{
+	struct bus *pbus = get_pbus(dev);
+	const struct pci_bus_operations *bops = pci_bus_ops(pbus, dev);
+	const int bus = dev->bus->secondary;
+	const int devfn = dev->path.pci.devfn;
+	unsigned int i;
+
+	if (bops->moving_block) {
+		bops->moving_block(pbus, bus, devfn, where, value, moving,
+				   count);
+		return;
+	}
+
+	for (i = 0; i < count; i++, where += 4) {
+		u32 ones, zeroes;
+
+		value[i] = bops->read32(pbus, bus, devfn, where);
+
+		bops->write32(pbus, bus, devfn, where, 0xffffffff);
+		ones = bops->read32(pbus, bus, devfn, where);
+
+		bops->write32(pbus, bus, devfn, where, 0x00000000);
+		zeroes = bops->read32(pbus, bus, devfn, where);
+
+		bops->write32(pbus, bus, devfn, where, value[i]);
+
+		moving[i] = ones ^ zeroes;
+	}
+}
+
 #if CONFIG_MMCONF_SUPPORT
 u8 pci_mmio_read_config8(struct device *dev, unsigned int where)
 {
@@ -211,14 +211,13 @@ static u8 elog_checksum_event(struct event_header *event)
 }
 
 /*
- * Check if mirrored buffer is filled with ELOG_TYPE_EOL byte from the
- * provided offset to the end of the mirrored buffer.
+ * Check if mirrored buffer is filled with ELOG_TYPE_EOL byte for size bytes
+ * from the provided offset.
  */
-static int elog_is_buffer_clear(size_t offset)
+static int elog_is_buffer_clear(size_t offset, size_t size)
 {
 	size_t i;
 	const struct region_device *rdev = mirror_dev_get();
-	size_t size = region_device_sz(rdev) - offset;
 	uint8_t *buffer = rdev_mmap(rdev, offset, size);
 	int ret = 1;
 
@@ -342,14 +341,48 @@ static void elog_nv_write(size_t offset, size_t size)
  * Erase the first block specified in the address.
  * Only handles flash area within a single flash block.
  */
-static void elog_nv_erase(void)
+static int elog_nv_erase(void)
 {
 	size_t size = region_device_sz(&nv_dev);
 	elog_debug("%s()\n", __func__);
 
 	/* Erase the sectors in this region */
-	if (rdev_eraseat(&nv_dev, 0, size) != size)
+	if (rdev_eraseat(&nv_dev, 0, size) != size) {
 		printk(BIOS_ERR, "ELOG: erase failure.\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Compare the first 'size' bytes of the flash backing store against the
+ * mirrored elog. Returns 1 if they match, 0 otherwise.
+ */
+static int elog_nv_matches_mirror(size_t size)
+{
+	uint8_t nv_buf[64];
+	const struct region_device *rdev = mirror_dev_get();
+	uint8_t *mirror;
+	size_t offset;
+	int ret = 1;
+
+	mirror = rdev_mmap(rdev, 0, size);
+	if (mirror == NULL)
+		return 0;
+
+	for (offset = 0; offset < size; offset += sizeof(nv_buf)) {
+		size_t len = MIN(sizeof(nv_buf), size - offset);
+
+		if (rdev_readat(&nv_dev, nv_buf, offset, len) != len ||
+		    memcmp(nv_buf, &mirror[offset], len)) {
+			ret = 0;
+			break;
+		}
+	}
+
+	rdev_munmap(rdev, mirror);
+	return ret;
 }
 
 /*
@@ -392,7 +425,8 @@ static int elog_update_event_buffer_state(void)
 	}
 
 	/* Ensure the remaining buffer is empty */
-	if (!elog_is_buffer_clear(offset)) {
+	if (!elog_is_buffer_clear(offset,
+			region_device_sz(mirror_dev_get()) - offset)) {
 		printk(BIOS_ERR, "ELOG: buffer not cleared from 0x%zx\n",
 			offset);
 		return -1;
@@ -420,8 +454,12 @@ static int elog_scan_flash(void)
 	/* No writes have been done yet. */
 	elog_tandem_reset_last_write();
 
-	/* Check if the area is empty or not */
-	if (elog_is_buffer_clear(0)) {
+	/*
+	 * Check if the area is empty or not. The whole area has to be
+	 * checked: a cleared header with stray data behind it must not be
+	 * taken as erased, or events would be appended over that data.
+	 */
+	if (elog_is_buffer_clear(0, region_device_sz(rdev))) {
 		printk(BIOS_ERR, "ELOG: NV Buffer Cleared.\n");
 		return -1;
 	}
@@ -707,7 +745,10 @@ static int elog_sync_to_nv(void)
 
 	/* Erase if necessary. */
 	if (erase_needed) {
-		elog_nv_erase();
+		if (elog_nv_erase() < 0) {
+			elog_initialized = ELOG_BROKEN;
+			return -1;
+		}
 		elog_nv_reset_last_write();
 	}
 
@@ -717,7 +758,7 @@ static int elog_sync_to_nv(void)
 	elog_nv_increment_last_write(size);
 
 	/*
-	 * If erase wasn't performed then don't rescan. Assume the appended
+	 * If erase wasn't performed then don't verify. Assume the appended
 	 * write was successful.
 	 */
 	if (!erase_needed)
@@ -725,10 +766,13 @@ static int elog_sync_to_nv(void)
 
 	elog_debug_dump_buffer("ELOG: in-memory mirror:\n");
 
-	/* Mark broken if the scan failed after a sync. */
-	if (elog_scan_flash() < 0) {
+	/*
+	 * The mirror is what was just written to the freshly erased area, so
+	 * reading back the written part is enough to verify the sync. There
+	 * is no need to re-read and re-parse the whole area.
+	 */
+	if (!elog_nv_matches_mirror(size)) {
 		printk(BIOS_ERR, "ELOG: Sync back from NV storage failed.\n");
-		elog_debug_dump_buffer("ELOG: Buffer from NV:\n");
 		elog_initialized = ELOG_BROKEN;
 		return -1;
 	}
@@ -21,6 +21,7 @@
 
 #include <boot_device.h>
 #include <spi_flash.h>
+#include <string.h>
 #include <symbols.h>
 #include <cbmem.h>
 #include <timer.h>
@@ -38,8 +39,7 @@ static struct spi_flash *spi_flash_info;
  */
 #define SPI_SPEED_DEBUG		0
 
-static ssize_t spi_readat(const struct region_device *rd, void *b,
-				size_t offset, size_t size)
+static ssize_t spi_readat_direct(void *b, size_t offset, size_t size)
 {
 	struct stopwatch sw;
 	bool show = SPI_SPEED_DEBUG && size >= 4 * KiB;
@@ -64,9 +64,67 @@ static ssize_t spi_readat(const struct region_device *rd, void *b,
 	return size;
 }
 
+/*
+ * Read-ahead buffer. Walking CBFS issues many small reads at increasing
+ * offsets which are dominated by the per transaction overhead of the SPI
+ * controller. A miss on a small read fills the whole window starting at the
+ * requested offset so that the following reads are served from memory.
+ */
+#define READAHEAD_SIZE CONFIG_COMMON_CBFS_SPI_READAHEAD
+
+#if READAHEAD_SIZE
+static struct {
+	uint8_t data[READAHEAD_SIZE];
+	size_t offset;
+	size_t size;
+} readahead;
+
+static void readahead_invalidate(size_t offset, size_t size)
+{
+	if (offset < readahead.offset + readahead.size &&
+	    offset + size > readahead.offset)
+		readahead.size = 0;
+}
+
+static ssize_t spi_readat(const struct region_device *rd, void *b,
+				size_t offset, size_t size)
+{
+	size_t fill;
+
+	if (size > READAHEAD_SIZE / 2)
+		return spi_readat_direct(b, offset, size);
+
+	if (offset < readahead.offset ||
+	    offset + size > readahead.offset + readahead.size) {
+		fill = MIN(READAHEAD_SIZE, region_device_sz(rd) - offset);
+		/* Data may be at the end of the device. */
+		if (fill < size)
+			return spi_readat_direct(b, offset, size);
+		readahead.size = 0;
+		if (spi_readat_direct(readahead.data, offset, fill) != fill)
+			return -1;
+		readahead.offset = offset;
+		readahead.size = fill;
+	}
+
+	memcpy(b, &readahead.data[offset - readahead.offset], size);
+
+	return size;
+}
+#else
+static void readahead_invalidate(size_t offset, size_t size) {}
+
+static ssize_t spi_readat(const struct region_device *rd, void *b,
+				size_t offset, size_t size)
+{
+	return spi_readat_direct(b, offset, size);
+}
+#endif
+
 static ssize_t spi_writeat(const struct region_device *rd, const void *b,
 				size_t offset, size_t size)
 {
+	readahead_invalidate(offset, size);
 	if (spi_flash_info->write(spi_flash_info, offset, size, b))
 		return -1;
 	return size;
@@ -75,6 +133,7 @@ static ssize_t spi_writeat(const struct region_device *rd, const void *b,
 static ssize_t spi_eraseat(const struct region_device *rd,
 				size_t offset, size_t size)
 {
+	readahead_invalidate(offset, size);
 	if (spi_flash_info->erase(spi_flash_info, offset, size))
 		return -1;
 	return size;
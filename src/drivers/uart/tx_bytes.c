@@ -0,0 +1,28 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <console/uart.h>
+
+/*
+ * UART drivers without a FIFO to burst into send the data byte by byte.
+ * This lives in its own file, because romcc_console.c includes util.c and
+ * the 8250 I/O driver into a single translation unit.
+ */
+void __attribute__((weak)) uart_tx_bytes(int idx, const void *data,
+					 size_t len)
+{
+	const unsigned char *bytes = data;
+
+	while (len--)
+		uart_tx_byte(idx, *bytes++);
+}
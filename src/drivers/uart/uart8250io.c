@@ -48,6 +48,32 @@ static void uart8250_tx_byte(unsigned base_port, unsigned char data)
 	outb(data, base_port + UART8250_TBR);
 }
 
+#ifndef __ROMCC__
+/*
+ * With the FIFO enabled THRE signals an empty FIFO, so a whole FIFO worth of
+ * data can be written after polling once.
+ */
+static void uart8250_tx_bytes(unsigned base_port, const unsigned char *data,
+			      size_t len)
+{
+	size_t burst = 1;
+
+	if ((inb(base_port + UART8250_IIR) & UART8250_IIR_FIFO) ==
+	    UART8250_IIR_FIFO)
+		burst = UART8250_FIFO_SIZE;
+
+	while (len) {
+		unsigned long int i = burst * SINGLE_CHAR_TIMEOUT;
+		size_t n = MIN(len, burst);
+
+		while (i-- && !uart8250_can_tx_byte(base_port));
+		len -= n;
+		while (n--)
+			outb(*data++, base_port + UART8250_TBR);
+	}
+}
+#endif
+
 static void uart8250_tx_flush(unsigned base_port)
 {
 	unsigned long int i = FIFO_TIMEOUT;
@@ -117,6 +143,13 @@ void uart_tx_byte(int idx, unsigned char data)
 	uart8250_tx_byte(uart_platform_base(idx), data);
 }
 
+#ifndef __ROMCC__
+void uart_tx_bytes(int idx, const void *data, size_t len)
+{
+	uart8250_tx_bytes(uart_platform_base(idx), data, len);
+}
+#endif
+
 unsigned char uart_rx_byte(int idx)
 {
 	return uart8250_rx_byte(uart_platform_base(idx));
@@ -21,6 +21,7 @@
 #include <delay.h>
 #include <rules.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "uart8250reg.h"
 
 /* Should support 8250, 16450, 16550, 16550A type UARTs */
@@ -67,6 +68,31 @@ static void uart8250_mem_tx_byte(void *base, unsigned char data)
 	uart8250_write(base, UART8250_TBR, data);
 }
 
+/*
+ * With the FIFO enabled THRE signals an empty FIFO, so a whole FIFO worth of
+ * data can be written after polling once.
+ */
+static void uart8250_mem_tx_bytes(void *base, const unsigned char *data,
+				  size_t len)
+{
+	size_t burst = 1;
+
+	if ((uart8250_read(base, UART8250_IIR) & UART8250_IIR_FIFO) ==
+	    UART8250_IIR_FIFO)
+		burst = UART8250_FIFO_SIZE;
+
+	while (len) {
+		unsigned long int i = burst * SINGLE_CHAR_TIMEOUT;
+		size_t n = MIN(len, burst);
+
+		while (i-- && !uart8250_mem_can_tx_byte(base))
+			udelay(1);
+		len -= n;
+		while (n--)
+			uart8250_write(base, UART8250_TBR, *data++);
+	}
+}
+
 static void uart8250_mem_tx_flush(void *base)
 {
 	unsigned long int i = FIFO_TIMEOUT;
@@ -130,6 +156,14 @@ void uart_tx_byte(int idx, unsigned char data)
 	uart8250_mem_tx_byte(base, data);
 }
 
+void uart_tx_bytes(int idx, const void *data, size_t len)
+{
+	void *base = uart_platform_baseptr(idx);
+	if (!base)
+		return;
+	uart8250_mem_tx_bytes(base, data, len);
+}
+
 unsigned char uart_rx_byte(int idx)
 {
 	void *base = uart_platform_baseptr(idx);
@@ -29,6 +29,22 @@ static void usbdebug_tx_byte(struct dbgp_pipe *pipe, unsigned char data)
 	dbgp_put(pipe);
 }
 
+/* Fill whole 8 byte packets while holding the pipe only once. */
+static void usbdebug_tx_bytes(struct dbgp_pipe *pipe,
+			      const unsigned char *data, size_t len)
+{
+	if (!dbgp_try_get(pipe))
+		return;
+	while (len--) {
+		pipe->buf[pipe->bufidx++] = *data++;
+		if (pipe->bufidx >= 8) {
+			dbgp_bulk_write_x(pipe, pipe->buf, pipe->bufidx);
+			pipe->bufidx = 0;
+		}
+	}
+	dbgp_put(pipe);
+}
+
 static void usbdebug_tx_flush(struct dbgp_pipe *pipe)
 {
 	if (!dbgp_try_get(pipe))
@@ -62,6 +78,11 @@ void usb_tx_byte(int idx, unsigned char data)
 	usbdebug_tx_byte(dbgp_console_output(), data);
 }
 
+void usb_tx_bytes(int idx, const void *data, size_t len)
+{
+	usbdebug_tx_bytes(dbgp_console_output(), data, len);
+}
+
 void usb_tx_flush(int idx)
 {
 	usbdebug_tx_flush(dbgp_console_output());
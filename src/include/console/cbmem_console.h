@@ -15,6 +15,7 @@
 #ifndef _CONSOLE_CBMEM_CONSOLE_H_
 #define _CONSOLE_CBMEM_CONSOLE_H_
 
+#include <console/vtxprintf.h>
 #include <rules.h>
 #include <stdint.h>
 
@@ -29,11 +30,37 @@ void cbmemc_tx_byte(unsigned char data);
 
 #if __CBMEM_CONSOLE_ENABLE__
 static inline void __cbmemc_init(void)	{ cbmemc_init(); }
+#if IS_ENABLED(CONFIG_CONSOLE_CBMEM_BINARY_LOG) && ENV_RAMSTAGE
+/* Ramstage output goes to the binary log instead. */
+static inline void __cbmemc_tx_byte(u8 data)	{}
+#else
 static inline void __cbmemc_tx_byte(u8 data)	{ cbmemc_tx_byte(data); }
+#endif
 #else
 static inline void __cbmemc_init(void)	{}
 static inline void __cbmemc_tx_byte(u8 data)	{}
 #endif
 
 void cbmem_dump_console(void);
+
+/*
+ * Record a printk() call in the binary log, see
+ * CONFIG_CONSOLE_CBMEM_BINARY_LOG. Called with the console lock held.
+ */
+#if IS_ENABLED(CONFIG_CONSOLE_CBMEM_BINARY_LOG) && ENV_RAMSTAGE
+void cbmem_binlog_vprintk(int msg_level, const char *fmt, va_list args);
+#else
+static inline void cbmem_binlog_vprintk(int msg_level, const char *fmt,
+					va_list args) {}
+#endif
+
+/*
+ * Send all ramstage output that is still waiting in the CBMEM console to the
+ * UART, see CONFIG_CONSOLE_CBMEM_DEFERRED_UART.
+ */
+#if IS_ENABLED(CONFIG_CONSOLE_CBMEM_DEFERRED_UART) && ENV_RAMSTAGE
+void cbmemc_drain_uart(void);
+#else
+static inline void cbmemc_drain_uart(void) {}
+#endif
 #endif
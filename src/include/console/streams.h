@@ -19,6 +19,9 @@
 
 void console_hw_init(void);
 void console_tx_byte(unsigned char byte);
+/* Same as calling console_tx_byte() for each byte, but lets the drivers
+ * that can send more than one byte at a time do so. */
+void console_tx_bytes(const void *data, size_t length);
 void console_tx_flush(void);
 
 /*
@@ -17,6 +17,7 @@
 #define CONSOLE_UART_H
 
 #include <rules.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Return the clock frequency UART uses as reference clock for
@@ -53,19 +54,38 @@ static inline void *uart_platform_baseptr(int idx)
 	return (void *)uart_platform_base(idx);
 }
 
+/*
+ * Send len bytes. Drivers with a transmit FIFO fill it in one go, the others
+ * get the generic fallback that sends them one by one.
+ */
+void uart_tx_bytes(int idx, const void *data, size_t len);
+
 void oxford_remap(unsigned int new_base);
 
 #define __CONSOLE_SERIAL_ENABLE__	CONFIG_CONSOLE_SERIAL && \
 	(ENV_BOOTBLOCK || ENV_ROMSTAGE || ENV_RAMSTAGE || ENV_VERSTAGE || \
 	ENV_POSTCAR || (ENV_SMM && CONFIG_DEBUG_SMI))
 
+/* Ramstage output may be sent from the CBMEM console instead. */
+#define __CONSOLE_SERIAL_DEFERRED__	\
+	IS_ENABLED(CONFIG_CONSOLE_CBMEM_DEFERRED_UART) && ENV_RAMSTAGE
+
 #if __CONSOLE_SERIAL_ENABLE__
 static inline void __uart_init(void)		{ uart_init(CONFIG_UART_FOR_CONSOLE); }
+#else
+static inline void __uart_init(void)		{}
+#endif
+
+#if __CONSOLE_SERIAL_ENABLE__ && !(__CONSOLE_SERIAL_DEFERRED__)
 static inline void __uart_tx_byte(u8 data)	{ uart_tx_byte(CONFIG_UART_FOR_CONSOLE, data); }
+static inline void __uart_tx_bytes(const void *data, size_t len)
+{
+	uart_tx_bytes(CONFIG_UART_FOR_CONSOLE, data, len);
+}
 static inline void __uart_tx_flush(void)	{ uart_tx_flush(CONFIG_UART_FOR_CONSOLE); }
 #else
-static inline void __uart_init(void)		{}
 static inline void __uart_tx_byte(u8 data)	{}
+static inline void __uart_tx_bytes(const void *data, size_t len) {}
 static inline void __uart_tx_flush(void)	{}
 #endif
 
@@ -18,11 +18,13 @@
 #define _CONSOLE_USB_H_
 
 #include <rules.h>
+#include <stddef.h>
 #include <stdint.h>
 
 int usbdebug_init(void);
 
 void usb_tx_byte(int idx, unsigned char data);
+void usb_tx_bytes(int idx, const void *data, size_t len);
 void usb_tx_flush(int idx);
 unsigned char usb_rx_byte(int idx);
 int usb_can_rx_byte(int idx);
@@ -36,10 +38,15 @@ int usb_can_rx_byte(int idx);
 #if __CONSOLE_USB_ENABLE__
 static inline void __usbdebug_init(void)	{ usbdebug_init(); }
 static inline void __usb_tx_byte(u8 data)	{ usb_tx_byte(USB_PIPE_FOR_CONSOLE, data); }
+static inline void __usb_tx_bytes(const void *data, size_t len)
+{
+	usb_tx_bytes(USB_PIPE_FOR_CONSOLE, data, len);
+}
 static inline void __usb_tx_flush(void)	{ usb_tx_flush(USB_PIPE_FOR_CONSOLE); }
 #else
 static inline void __usbdebug_init(void)	{}
 static inline void __usb_tx_byte(u8 data)	{}
+static inline void __usb_tx_bytes(const void *data, size_t len) {}
 static inline void __usb_tx_flush(void)	{}
 #endif
 
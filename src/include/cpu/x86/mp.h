@@ -82,9 +82,19 @@ struct mp_ops {
 	 * this callback is called after SMM handlers have been loaded.
 	 */
 	void (*pre_mp_smm_init)(void);
+	/*
+	 * Optionally return non-zero if the CPUs can take their relocation
+	 * SMIs concurrently. That is the case when the save state of the
+	 * relocation handler doesn't live in the default SMRAM shared by all
+	 * CPUs, e.g. because it is kept in MSRs. It is only consulted when
+	 * per_cpu_smm_trigger() isn't provided.
+	 */
+	int (*parallel_smm_relocation)(void);
 	/*
 	 * Optional function to use to trigger SMM to perform relocation. If
-	 * not provided, smm_initiate_relocation() is used.
+	 * not provided, smm_initiate_relocation() is used, or
+	 * smm_initiate_relocation_parallel() if parallel_smm_relocation()
+	 * returned non-zero.
 	 */
 	void (*per_cpu_smm_trigger)(void);
 	/*
@@ -117,13 +127,55 @@ struct mp_ops {
  * 6. adjust_smm_params(is_perm = 0)
  * 7. adjust_smm_params(is_perm = 1)
  * 8. pre_mp_smm_init()
- * 9. per_cpu_smm_trigger() in parallel for all cpus which calls
- *    relocation_handler() in SMM.
- * 10. mp_initialize_cpu() for each cpu
- * 11. post_mp_init()
+ * 9. parallel_smm_relocation()
+ * 10. per_cpu_smm_trigger() in parallel for all cpus which calls
+ *     relocation_handler() in SMM.
+ * 11. mp_initialize_cpu() for each cpu
+ * 12. post_mp_init()
  */
 int mp_init_with_smm(struct bus *cpu_bus, const struct mp_ops *mp_ops);
 
+/*
+ * The following functions are only functional when
+ * CONFIG_PARALLEL_MP_AP_WORK is selected. The APs then wait for jobs after
+ * mp_init_with_smm() instead of being parked, until mp_park_aps() is called
+ * which happens automatically before entering the payload or resuming the OS.
+ */
+
+/* Return the number of APs which accept jobs. APs are numbered 1 to count. */
+int mp_get_ap_count(void);
+/*
+ * Queue func(arg) to be run on the AP with the given coreboot CPU index. An
+ * AP holds one pending job at a time. Returns < 0 if the AP did not pick up
+ * its previous job within expire_us microseconds (0 or less waits forever),
+ * 0 once the job is queued. Completion of func must be tracked by the caller.
+ */
+int mp_run_on_ap(int cpu, void (*func)(void *), void *arg, long expire_us);
+/*
+ * Queue func(arg) on every AP which accepts jobs. Returns the number of APs
+ * the job was queued on, see mp_run_on_ap() for expire_us. Completion of
+ * func must be tracked by the caller.
+ */
+int mp_run_on_aps(void (*func)(void *), void *arg, long expire_us);
+/*
+ * Run func(arg) on the BSP and on every AP which accepts jobs, and return
+ * once all of them are done. Returns the number of CPUs which ran func.
+ */
+int mp_run_on_all_cpus(void (*func)(void *), void *arg, long expire_us);
+/*
+ * Call func(arg, index) for each index from 0 to count - 1. The BSP and all
+ * APs which are idle take the next index from a shared counter until none
+ * are left. Returns once all calls are done, with the number of CPUs that
+ * took part. Without APs everything runs on the BSP. func can find out on
+ * which CPU it runs through cpu_index().
+ *
+ * These functions must only be called by the BSP, and not while one of
+ * them is already running.
+ */
+int mp_run_queue(void (*func)(void *arg, int index), void *arg, int count);
+/* Put all APs back to sleep. No jobs can be run on the APs afterwards. */
+void mp_park_aps(void);
+
 /*
  * SMM helpers to use with initializing CPUs.
  */
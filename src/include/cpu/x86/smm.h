@@ -557,6 +557,8 @@ struct smm_loader_params {
 /* Both of these return 0 on success, < 0 on failure. */
 int smm_setup_relocation_handler(struct smm_loader_params *params);
 int smm_load_module(void *smram, int size, struct smm_loader_params *params);
+/* Return the SMBASE smm_load_module() placed a CPU at, 0 if out of range. */
+uintptr_t smm_get_cpu_smbase(int cpu);
 
 /* Backup and restore default SMM region. */
 void *backup_default_smm_area(void);
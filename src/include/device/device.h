@@ -46,6 +46,13 @@ struct device_operations {
 	void (*set_resources)(device_t dev);
 	void (*enable_resources)(device_t dev);
 	void (*init)(device_t dev);
+	/*
+	 * With CONFIG_ASYNC_DEVICE_INIT, init() may overlap with the init() of
+	 * other devices. It only waits for the parent bridge and the devices
+	 * declared with dev_init_depends_on() from init_dependencies().
+	 */
+	int init_async;
+	void (*init_dependencies)(device_t dev);
 	void (*final)(device_t dev);
 	void (*scan_bus)(device_t bus);
 	void (*enable)(device_t dev);
@@ -101,6 +108,8 @@ struct bus {
  * combination:
  */
 
+#define DEVICE_MAX_INIT_DEPS 4
+
 struct pci_irq_info {
 	unsigned int	ioapic_irq_pin;
 	unsigned int	ioapic_src_pin;
@@ -143,6 +152,14 @@ struct device {
 	const char *name;
 #endif
 	ROMSTAGE_CONST void *chip_info;
+#if IS_ENABLED(CONFIG_ASYNC_DEVICE_INIT)
+	/* Book keeping of dev_initialize(). Times are relative to its start. */
+	u8 init_state;
+	struct device *init_deps[DEVICE_MAX_INIT_DEPS];
+	struct device *init_critical;
+	long init_start;
+	long init_finish;
+#endif
 };
 
 /**
@@ -172,6 +189,12 @@ void dev_enumerate(void);
 void dev_configure(void);
 void dev_enable(void);
 void dev_initialize(void);
+#if IS_ENABLED(CONFIG_ASYNC_DEVICE_INIT)
+void dev_init_depends_on(struct device *dev, struct device *dep);
+#else
+static inline void dev_init_depends_on(struct device *dev,
+				       struct device *dep) {}
+#endif
 void dev_optimize(void);
 void dev_finalize(void);
 void dev_finalize_chips(void);
@@ -229,6 +252,8 @@ void show_all_devs_resources(int debug_level, const char* msg);
 
 extern struct device_operations default_dev_ops_root;
 void pci_domain_read_resources(struct device *dev);
+void pci_domain_add_mem64_window(struct device *dev, resource_t base,
+				 resource_t limit);
 void pci_domain_scan_bus(struct device *dev);
 
 void fixed_mem_resource(device_t dev, unsigned long index,
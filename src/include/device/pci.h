@@ -44,6 +44,17 @@ struct pci_bus_operations {
 	void (*write8)  (struct bus *pbus, int bus, int devfn, int where, uint8_t val);
 	void (*write16) (struct bus *pbus, int bus, int devfn, int where, uint16_t val);
 	void (*write32) (struct bus *pbus, int bus, int devfn, int where, uint32_t val);
+	/*
+	 * Optional, for count consecutive dword registers starting at where:
+	 * read_block() reads them into buf. moving_block() stores the
+	 * current value of each, finds the bits that can be written and
+	 * restores the value, like pci_moving_config32().
+	 */
+	void (*read_block) (struct bus *pbus, int bus, int devfn, int where,
+			    uint32_t *buf, unsigned int count);
+	void (*moving_block) (struct bus *pbus, int bus, int devfn, int where,
+			      uint32_t *value, uint32_t *moving,
+			      unsigned int count);
 };
 
 struct pci_driver {
@@ -77,6 +88,11 @@ void do_pci_scan_bridge(device_t bus,
 
 void pci_scan_bridge(device_t bus);
 void pci_scan_bus(struct bus *bus, unsigned min_devfn, unsigned max_devfn);
+#if IS_ENABLED(CONFIG_PCI_PARALLEL_ROOT_PROBE)
+void pci_probe_root_bus(struct bus *bus);
+#else
+static inline void pci_probe_root_bus(struct bus *bus) {}
+#endif
 
 uint8_t pci_moving_config8(struct device *dev, unsigned reg);
 uint16_t pci_moving_config16(struct device *dev, unsigned reg);
@@ -12,6 +12,11 @@ u32 pci_read_config32(struct device *dev, unsigned int where);
 void pci_write_config8(struct device *dev, unsigned int where, u8 val);
 void pci_write_config16(struct device *dev, unsigned int where, u16 val);
 void pci_write_config32(struct device *dev, unsigned int where, u32 val);
+/* Access count consecutive dword registers with one bus lookup. */
+void pci_read_config32_block(struct device *dev, unsigned int where,
+			     u32 *buf, unsigned int count);
+void pci_moving_config32_block(struct device *dev, unsigned int where,
+			       u32 *value, u32 *moving, unsigned int count);
 
 #if CONFIG_MMCONF_SUPPORT
 u8 pci_mmio_read_config8(struct device *dev, unsigned int where);
@@ -22,6 +22,15 @@
 
 /* Defined in src/lib/lzma.c. Returns decompressed size or 0 on error. */
 size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn);
+/* Same as ulzman() but uses the caller provided decoder state of
+ * ULZMA_SCRATCH_SIZE bytes, allowing concurrent decompressions. */
+#define ULZMA_SCRATCH_SIZE 15980
+size_t ulzma_with_scratch(const void *src, size_t srcn, void *dst,
+			  size_t dstn, void *scratchpad);
+/* Same as ulzman() but pulls the compressed input through the read()
+ * callback in small windows, see ulz4fn_stream() in commonlib. */
+size_t ulzman_stream(size_t (*read)(void *arg, void *buf, size_t size),
+		     void *arg, void *dst, size_t dstn);
 
 /* Defined in src/lib/ramtest.c */
 void ram_check(unsigned long start, unsigned long stop);
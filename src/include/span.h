@@ -0,0 +1,34 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __SPAN_H__
+#define __SPAN_H__
+
+#include <rules.h>
+#include <commonlib/span_serialized.h>
+
+#if IS_ENABLED(CONFIG_BOOT_SPANS) && ENV_RAMSTAGE
+/*
+ * Mark the beginning and the end of a named span of boot time. Spans have to
+ * be properly nested, every span_begin() needs a matching span_end(). The
+ * name is copied, so it may live on the stack, but it is truncated to
+ * SPAN_NAME_LEN - 1 characters. Only the boot CPU records spans.
+ */
+void span_begin(const char *name);
+void span_end(const char *name);
+#else
+static inline void span_begin(const char *name) {}
+static inline void span_end(const char *name) {}
+#endif
+
+#endif
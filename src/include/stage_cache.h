@@ -36,6 +36,23 @@ void stage_cache_external_region(void **base, size_t *size);
 struct stage_cache {
 	uint64_t load_addr;
 	uint64_t entry_addr;
+	/*
+	 * Size of the stage in memory. Only the part up to the last non-zero
+	 * byte is cached. The rest, typically the bss, is zeroed on load.
+	 */
+	uint64_t mem_size;
 };
 
+/* Return the size of the stage's image without its trailing zero bytes. */
+static inline size_t stage_cache_data_size(const struct prog *stage)
+{
+	const uint8_t *start = prog_start(stage);
+	size_t size = prog_size(stage);
+
+	while (size > 0 && start[size - 1] == 0)
+		size--;
+
+	return size;
+}
+
 #endif /* _STAGE_CACHE_H_ */
@@ -2,14 +2,22 @@
 #define STDLIB_H
 
 #include <stddef.h>
+#include <rules.h>
 
 #define min(a,b) MIN((a),(b))
 #define max(a,b) MAX((a),(b))
 
 void *memalign(size_t boundary, size_t size);
 void *malloc(size_t size);
+/* malloc.c is only built into ramstage and TSEG based SMM handlers. */
+#if IS_ENABLED(CONFIG_HEAP_FREELIST) && \
+	(ENV_RAMSTAGE || (ENV_SMM && IS_ENABLED(CONFIG_SMM_TSEG)))
+void free(void *ptr);
+void *realloc(void *ptr, size_t size);
+#else
 /* We never free memory */
 static inline void free(void *ptr) {}
+#endif
 
 #ifndef __ROMCC__
 static inline unsigned long div_round_up(unsigned int n, unsigned int d)
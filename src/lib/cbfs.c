@@ -18,7 +18,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <boot_device.h>
+#include <bootstate.h>
 #include <cbfs.h>
+#include <cbmem.h>
 #include <commonlib/compression.h>
 #include <endian.h>
 #include <lib.h>
@@ -35,13 +37,60 @@
 #define DEBUG(x...)
 #endif
 
-int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type)
+/*
+ * The CBFS lookup cache is an index of every file in the boot CBFS which is
+ * built by a single walk over the CBFS early in ramstage, as soon as CBMEM
+ * is available. The index lives in CBMEM and is hashed by file name so that
+ * later lookups, including the ones for files which don't exist, do not
+ * need to read all the file headers from the boot device again.
+ */
+#define CBFS_CACHE_MAGIC 0x43424643
+#define CBFS_CACHE_ENTRIES CONFIG_CBFS_LOOKUP_CACHE_ENTRIES
+/* Twice as many hash buckets as entries keeps the probe sequences short. */
+#define CBFS_CACHE_BUCKETS (2 * CBFS_CACHE_ENTRIES)
+
+struct cbfs_cache_entry {
+	uint32_t hash;
+	uint32_t type;
+	/* Offset of the file header relative to the start of the CBFS. */
+	uint32_t offset;
+	/* Size of the metadata, i.e. offset of the data from the header. */
+	uint32_t metadata_size;
+	uint32_t data_size;
+};
+
+struct cbfs_cache {
+	uint32_t magic;
+	uint32_t cbfs_offset;
+	uint32_t cbfs_size;
+	uint32_t num_entries;
+	/*
+	 * Index + 1 into entries[]. 0 marks an empty bucket. Kconfig limits
+	 * the number of entries to what fits.
+	 */
+	uint16_t buckets[CBFS_CACHE_BUCKETS];
+	struct cbfs_cache_entry entries[CBFS_CACHE_ENTRIES];
+};
+
+/* FNV-1a hash over the file name. */
+static uint32_t cbfs_cache_hash(const char *name)
+{
+	uint32_t hash = 2166136261;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+static int cbfs_boot_rdev(struct region_device *rdev,
+			  struct cbfs_props *props)
 {
-	struct region_device rdev;
 	const struct region_device *boot_dev;
-	struct cbfs_props props;
 
-	if (cbfs_boot_region_properties(&props))
+	if (cbfs_boot_region_properties(props))
 		return -1;
 
 	/* All boot CBFS operations are performed using the RO devie. */
@@ -50,9 +99,209 @@ int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type)
 	if (boot_dev == NULL)
 		return -1;
 
-	if (rdev_chain(&rdev, boot_dev, props.offset, props.size))
+	return rdev_chain(rdev, boot_dev, props->offset, props->size);
+}
+
+/* Only set once the cache was built by this stage. A cache found in CBMEM
+ * could have been left behind by a previous boot (S3 resume). */
+static struct cbfs_cache *cbfs_cache;
+
+#if IS_ENABLED(CONFIG_CBFS_LOOKUP_CACHE) && ENV_RAMSTAGE
+static int cbfs_cache_insert(struct cbfs_cache *cache,
+				const struct region_device *cbfs,
+				const struct cbfsf *fh)
+{
+	const size_t fsz = sizeof(struct cbfs_file);
+	struct cbfs_cache_entry *e;
+	struct cbfs_file *file;
+	size_t bucket;
+
+	file = rdev_mmap_full(&fh->metadata);
+
+	if (file == NULL)
+		return -1;
+
+	e = &cache->entries[cache->num_entries];
+	e->hash = cbfs_cache_hash((const char *)file + fsz);
+	e->type = ntohl(file->type);
+	e->offset = rdev_relative_offset(cbfs, &fh->metadata);
+	e->metadata_size = region_device_sz(&fh->metadata);
+	e->data_size = region_device_sz(&fh->data);
+
+	rdev_munmap(&fh->metadata, file);
+
+	bucket = e->hash % CBFS_CACHE_BUCKETS;
+	while (cache->buckets[bucket] != 0)
+		bucket = (bucket + 1) % CBFS_CACHE_BUCKETS;
+
+	cache->buckets[bucket] = ++cache->num_entries;
+
+	return 0;
+}
+
+static int cbfs_cache_fill(struct cbfs_cache *cache,
+				const struct region_device *cbfs,
+				const struct cbfs_props *props)
+{
+	struct cbfsf f;
+	struct cbfsf *prev;
+	int ret;
+
+	memset(cache, 0, sizeof(*cache));
+	prev = NULL;
+
+	while ((ret = cbfs_for_each_file(cbfs, prev, &f)) == 0) {
+		prev = &f;
+		if (cache->num_entries >= CBFS_CACHE_ENTRIES) {
+			LOG("More than %d files, not using lookup cache.\n",
+				CBFS_CACHE_ENTRIES);
+			return -1;
+		}
+		if (cbfs_cache_insert(cache, cbfs, &f)) {
+			ERROR("Unable to add file @ %zx to lookup cache.\n",
+				rdev_relative_offset(cbfs, &f.metadata));
+			return -1;
+		}
+	}
+
+	if (ret < 0)
+		return -1;
+
+	cache->cbfs_offset = props->offset;
+	cache->cbfs_size = props->size;
+	cache->magic = CBFS_CACHE_MAGIC;
+
+	LOG("Lookup cache holds %u files.\n", cache->num_entries);
+
+	return 0;
+}
+
+/*
+ * The cache is added to CBMEM at a fixed point, so that it is in place
+ * before the tables describing CBMEM are written.
+ */
+static void cbfs_cache_init(void *unused)
+{
+	struct region_device rdev;
+	struct cbfs_props props;
+	struct cbfs_cache *cache;
+
+	if (cbfs_boot_rdev(&rdev, &props))
+		return;
+
+	cache = cbmem_add(CBMEM_ID_CBFS_CACHE, sizeof(*cache));
+
+	if (cache == NULL)
+		return;
+
+	if (cbfs_cache_fill(cache, &rdev, &props)) {
+		cache->magic = 0;
+		return;
+	}
+
+	cbfs_cache = cache;
+}
+
+/* Without EARLY_CBMEM_INIT, CBMEM is only set up on entry to BS_POST_DEVICE. */
+#if IS_ENABLED(CONFIG_EARLY_CBMEM_INIT)
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_EXIT, cbfs_cache_init, NULL);
+#else
+BOOT_STATE_INIT_ENTRY(BS_POST_DEVICE, BS_ON_EXIT, cbfs_cache_init, NULL);
+#endif
+#endif
+
+static struct cbfs_cache *cbfs_cache_get(const struct cbfs_props *props)
+{
+	struct cbfs_cache *cache = cbfs_cache;
+
+	if (!IS_ENABLED(CONFIG_CBFS_LOOKUP_CACHE) || !ENV_RAMSTAGE ||
+	    cache == NULL)
+		return NULL;
+
+	if (cache->magic != CBFS_CACHE_MAGIC ||
+	    cache->cbfs_offset != props->offset ||
+	    cache->cbfs_size != props->size)
+		return NULL;
+
+	return cache;
+}
+
+/* Returns 0 when found, > 0 when the file is not in the cache and < 0 when
+ * the cache entry does not match the CBFS contents anymore. */
+static int cbfs_cache_locate(const struct cbfs_cache *cache,
+				struct cbfsf *fh,
+				const struct region_device *cbfs,
+				const char *name, uint32_t *type)
+{
+	const size_t fsz = sizeof(struct cbfs_file);
+	const uint32_t hash = cbfs_cache_hash(name);
+	size_t bucket = hash % CBFS_CACHE_BUCKETS;
+
+	for (; cache->buckets[bucket] != 0;
+	     bucket = (bucket + 1) % CBFS_CACHE_BUCKETS) {
+		const struct cbfs_cache_entry *e;
+		char *fname;
+		int name_match;
+
+		e = &cache->entries[cache->buckets[bucket] - 1];
+
+		if (e->hash != hash)
+			continue;
+
+		if (rdev_chain(&fh->metadata, cbfs, e->offset,
+				e->metadata_size))
+			return -1;
+
+		/* Guard against hash collisions and stale entries. */
+		fname = rdev_mmap(&fh->metadata, fsz, e->metadata_size - fsz);
+		if (fname == NULL)
+			return -1;
+
+		name_match = !strcmp(fname, name);
+		rdev_munmap(&fh->metadata, fname);
+
+		if (!name_match)
+			continue;
+
+		if (type != NULL && *type != e->type)
+			continue;
+
+		if (rdev_chain(&fh->data, cbfs, e->offset + e->metadata_size,
+				e->data_size))
+			return -1;
+
+		DEBUG("Cache hit for '%s' @ offset %x size %x\n", name,
+			e->offset, e->data_size);
+
+		return 0;
+	}
+
+	return 1;
+}
+
+int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type)
+{
+	struct region_device rdev;
+	struct cbfs_props props;
+	const struct cbfs_cache *cache;
+
+	if (cbfs_boot_rdev(&rdev, &props))
 		return -1;
 
+	cache = cbfs_cache_get(&props);
+
+	if (cache != NULL) {
+		int ret = cbfs_cache_locate(cache, fh, &rdev, name, type);
+
+		if (ret == 0)
+			return 0;
+		/* Every file in the CBFS is indexed. */
+		if (ret > 0) {
+			LOG("'%s' not found.\n", name);
+			return -1;
+		}
+	}
+
 	return cbfs_locate(fh, &rdev, name, type);
 }
 
@@ -78,9 +327,38 @@ void *cbfs_boot_map_with_leak(const char *name, uint32_t type, size_t *size)
 
 
 
+struct cbfs_stream {
+	const struct region_device *rdev;
+	size_t offset;
+	size_t remaining;
+};
+
+/* Input callback for the streaming decompressors. */
+static size_t cbfs_stream_read(void *arg, void *buf, size_t size)
+{
+	struct cbfs_stream *s = arg;
+
+	size = MIN(size, s->remaining);
+	if (size == 0)
+		return 0;
+	if (rdev_readat(s->rdev, buf, s->offset, size) != size)
+		return 0;
+
+	s->offset += size;
+	s->remaining -= size;
+
+	return size;
+}
+
 size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression)
 {
+	struct cbfs_stream stream = {
+		.rdev = rdev,
+		.offset = offset,
+		.remaining = in_size,
+	};
+
 	size_t out_size;
 
 	switch (compression) {
@@ -97,6 +375,14 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 		    !IS_ENABLED(CONFIG_COMPRESS_PRERAM_STAGES))
 			return 0;
 
+		if (IS_ENABLED(CONFIG_CBFS_STREAMING_DECOMPRESSION)) {
+			timestamp_add_now(TS_START_ULZ4F);
+			out_size = ulz4fn_stream(cbfs_stream_read, &stream,
+						 buffer, buffer_size);
+			timestamp_add_now(TS_END_ULZ4F);
+			break;
+		}
+
 		/* Load the compressed image to the end of the available memory
 		 * area for in-place decompression. It is the responsibility of
 		 * the caller to ensure that buffer_size is large enough
@@ -116,6 +402,15 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 		if ((ENV_ROMSTAGE || ENV_POSTCAR)
 			&& !IS_ENABLED(CONFIG_COMPRESS_RAMSTAGE))
 			return 0;
+
+		if (IS_ENABLED(CONFIG_CBFS_STREAMING_DECOMPRESSION)) {
+			timestamp_add_now(TS_START_ULZMA);
+			out_size = ulzman_stream(cbfs_stream_read, &stream,
+						 buffer, buffer_size);
+			timestamp_add_now(TS_END_ULZMA);
+			break;
+		}
+
 		void *map = rdev_mmap(rdev, offset, in_size);
 		if (map == NULL)
 			return 0;
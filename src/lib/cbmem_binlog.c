@@ -0,0 +1,276 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <cbmem.h>
+#include <commonlib/binlog_serialized.h>
+#include <commonlib/helpers.h>
+#include <console/cbmem_console.h>
+#include <console/console.h>
+#include <string.h>
+#include <symbols.h>
+
+/* Bytes of records kept in BSS until cbmem comes online. */
+#define BINLOG_EARLY_SIZE 2048
+
+static struct {
+	struct binlog_buffer buf;
+	/* Storage for the records of the buffer above. */
+	u8 body[BINLOG_EARLY_SIZE];
+} binlog_early = {
+	.buf.size = BINLOG_EARLY_SIZE,
+	.buf.pointer_size = sizeof(void *),
+};
+
+static struct binlog_buffer *binlog = &binlog_early.buf;
+
+static const char binlog_check[] = BINLOG_CHECK_STRING;
+
+struct binlog_writer {
+	u8 *pos;
+	u8 *end;
+	int overflow;
+};
+
+static void put_byte(struct binlog_writer *w, u8 byte)
+{
+	if (w->pos == w->end) {
+		w->overflow = 1;
+		return;
+	}
+	*w->pos++ = byte;
+}
+
+static void put_unsigned(struct binlog_writer *w, u64 val)
+{
+	while (val >= 0x80) {
+		put_byte(w, (val & 0x7f) | 0x80);
+		val >>= 7;
+	}
+	put_byte(w, val);
+}
+
+static void put_signed(struct binlog_writer *w, int64_t val)
+{
+	/* Zigzag, so that small negative numbers stay short. */
+	put_unsigned(w, ((u64)val << 1) ^ (u64)(val >> 63));
+}
+
+static void binlog_tx_byte(unsigned char byte, void *data)
+{
+	put_byte(data, byte);
+}
+
+/*
+ * Store the arguments consumed by fmt. This has to walk the format string
+ * exactly like vtxprintf() does, and cbmem has to walk it the same way.
+ */
+static void binlog_put_args(struct binlog_writer *w, const char *fmt,
+			    va_list args)
+{
+	const char *s;
+	int precision;
+	int qualifier;
+	int sign;
+
+	for (; *fmt; fmt++) {
+		if (*fmt != '%')
+			continue;
+		fmt++;
+
+		while (*fmt == '-' || *fmt == '+' || *fmt == ' ' ||
+		       *fmt == '#' || *fmt == '0')
+			fmt++;
+
+		if (*fmt == '*') {
+			fmt++;
+			put_signed(w, va_arg(args, int));
+		} else {
+			while (isdigit(*fmt))
+				fmt++;
+		}
+
+		precision = -1;
+		if (*fmt == '.') {
+			fmt++;
+			precision = 0;
+			if (*fmt == '*') {
+				fmt++;
+				precision = va_arg(args, int);
+				put_signed(w, precision);
+			} else {
+				while (isdigit(*fmt))
+					precision = precision * 10 + *fmt++ - '0';
+			}
+			if (precision < 0)
+				precision = 0;
+		}
+
+		qualifier = -1;
+		if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z') {
+			qualifier = *fmt;
+			++fmt;
+			if (*fmt == 'l') {
+				qualifier = 'L';
+				++fmt;
+			}
+			if (*fmt == 'h') {
+				qualifier = 'H';
+				++fmt;
+			}
+		}
+
+		sign = 0;
+		switch (*fmt) {
+		case 'c':
+			put_unsigned(w, (unsigned char)va_arg(args, int));
+			continue;
+
+		case 's':
+			s = va_arg(args, const char *);
+			if (!s)
+				s = "<NULL>";
+			for (; precision-- && *s; s++)
+				put_byte(w, *s);
+			put_byte(w, '\0');
+			continue;
+
+		case 'p':
+			put_unsigned(w, (unsigned long)va_arg(args, void *));
+			continue;
+
+		case 'n':
+			/* Nothing is written back, but the pointer is used up. */
+			va_arg(args, void *);
+			continue;
+
+		case 'd':
+		case 'i':
+			sign = 1;
+			break;
+
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			break;
+
+		case '\0':
+			/* A lone '%' at the end, vtxprintf() prints it. */
+			return;
+
+		default:
+			continue;
+		}
+
+		if (qualifier == 'L') {
+			if (sign)
+				put_signed(w, va_arg(args, long long));
+			else
+				put_unsigned(w, va_arg(args, unsigned long long));
+		} else if (qualifier == 'l') {
+			if (sign)
+				put_signed(w, va_arg(args, long));
+			else
+				put_unsigned(w, va_arg(args, unsigned long));
+		} else if (qualifier == 'z') {
+			put_unsigned(w, va_arg(args, size_t));
+		} else if (qualifier == 'h') {
+			if (sign)
+				put_signed(w, (short)va_arg(args, int));
+			else
+				put_unsigned(w, (unsigned short)va_arg(args, int));
+		} else if (qualifier == 'H') {
+			if (sign)
+				put_signed(w, (signed char)va_arg(args, int));
+			else
+				put_unsigned(w, (unsigned char)va_arg(args, int));
+		} else if (sign) {
+			put_signed(w, va_arg(args, int));
+		} else {
+			put_unsigned(w, va_arg(args, unsigned int));
+		}
+	}
+}
+
+static void binlog_append(struct binlog_buffer *buf, int level,
+			  const char *fmt, va_list args)
+{
+	struct binlog_record *rec;
+	struct binlog_writer w;
+
+	if (buf->cursor + sizeof(*rec) > buf->size) {
+		buf->dropped++;
+		return;
+	}
+
+	rec = (struct binlog_record *)&buf->body[buf->cursor];
+	w.pos = rec->args;
+	w.end = w.pos + MIN(buf->size - buf->cursor - sizeof(*rec), 0xffff);
+	w.overflow = 0;
+
+	/*
+	 * Only format strings that are part of the ramstage image can be
+	 * looked up later. Anything else is formatted right away.
+	 */
+	if (fmt >= (const char *)_program && fmt < (const char *)_eprogram) {
+		rec->format = fmt - (const char *)_program;
+		binlog_put_args(&w, fmt, args);
+	} else {
+		rec->format = BINLOG_FORMAT_TEXT;
+		vtxprintf(binlog_tx_byte, fmt, args, &w);
+	}
+
+	if (w.overflow) {
+		buf->dropped++;
+		return;
+	}
+
+	rec->length = w.pos - rec->args;
+	rec->level = level;
+	rec->reserved = 0;
+	buf->cursor += sizeof(*rec) + rec->length;
+}
+
+void cbmem_binlog_vprintk(int msg_level, const char *fmt, va_list args)
+{
+	binlog_append(binlog, msg_level, fmt, args);
+}
+
+static void binlog_sync_early_to_cbmem(int is_recovery)
+{
+	struct binlog_buffer *buf;
+	const size_t size = CONFIG_CONSOLE_CBMEM_BINARY_LOG_SIZE;
+
+	buf = cbmem_add(CBMEM_ID_BINLOG, sizeof(*buf) + size);
+	if (buf == NULL) {
+		printk(BIOS_ERR, "ERROR: No binary log buffer allocated\n");
+		return;
+	}
+
+	/* A log recovered from a previous boot is simply overwritten. */
+	buf->size = size;
+	buf->cursor = 0;
+	buf->dropped = binlog_early.buf.dropped;
+	buf->format_check = binlog_check - (const char *)_program;
+	buf->pointer_size = sizeof(void *);
+	memset(buf->reserved, 0, sizeof(buf->reserved));
+
+	if (binlog_early.buf.cursor <= size) {
+		memcpy(buf->body, binlog_early.body, binlog_early.buf.cursor);
+		buf->cursor = binlog_early.buf.cursor;
+	}
+
+	binlog = buf;
+}
+
+RAMSTAGE_CBMEM_INIT_HOOK(binlog_sync_early_to_cbmem)
@@ -18,8 +18,11 @@
 #include <console/uart.h>
 #include <cbmem.h>
 #include <arch/early_variables.h>
+#include <bootstate.h>
 #include <symbols.h>
+#include <stdlib.h>
 #include <string.h>
+#include <thread.h>
 
 /*
  * Structure describing console buffer. It is overlaid on a flat memory area,
@@ -66,6 +69,18 @@ static u8 static_console[STATIC_CONSOLE_SIZE];
 #define CBMEMC_RESET	(1<<0)
 #define CBMEMC_APPEND	(1<<1)
 
+#define DEFERRED_UART	(IS_ENABLED(CONFIG_CONSOLE_CBMEM_DEFERRED_UART) && \
+			 ENV_RAMSTAGE)
+
+#if DEFERRED_UART
+/* Console data before this offset has been sent to the UART. */
+static u32 uart_cursor;
+/* Set while the drain thread is sending data. */
+static int uart_drain_busy;
+/* Tells the drain thread to exit once it caught up. */
+static int uart_drain_stop;
+#endif
+
 static inline struct cbmem_console *current_console(void)
 {
 	return car_sync_var(cbmem_console_p);
@@ -89,11 +104,22 @@ static inline void init_console_ptr(void *storage, u32 total_space, int flags)
 		cbm_cons_p->buffer_size = total_space - sizeof(struct cbmem_console);
 		cbm_cons_p->buffer_cursor = 0;
 	}
+#if DEFERRED_UART
+	/* Anything already in the new buffer was sent by an earlier stage. */
+	if (!(flags & CBMEMC_APPEND) || !current_console())
+		uart_cursor = cbm_cons_p->buffer_cursor;
+	else
+		uart_cursor += cbm_cons_p->buffer_cursor;
+#endif
 	if (flags & CBMEMC_APPEND) {
 		struct cbmem_console *tmp_cons_p = current_console();
 		if (tmp_cons_p)
 			copy_console_buffer(tmp_cons_p, cbm_cons_p);
 	}
+#if DEFERRED_UART
+	if (uart_cursor > cbm_cons_p->buffer_cursor)
+		uart_cursor = cbm_cons_p->buffer_cursor;
+#endif
 
 	current_console_set(cbm_cons_p);
 }
@@ -249,6 +275,97 @@ ROMSTAGE_CBMEM_INIT_HOOK(cbmemc_reinit)
 RAMSTAGE_CBMEM_INIT_HOOK(cbmemc_reinit)
 POSTCAR_CBMEM_INIT_HOOK(cbmemc_reinit)
 
+#if DEFERRED_UART
+/* Longest run of console data sent in one go by the drain thread. */
+#define UART_DRAIN_CHUNK	16
+/* How long the drain thread sleeps when there is nothing to send. */
+#define UART_DRAIN_IDLE_USECS	1000
+
+/* Send up to max bytes of new console data to the UART, return how many. */
+static size_t uart_drain(size_t max)
+{
+	struct cbmem_console *cbm_cons_p = current_console();
+	const u8 *data;
+	size_t len, start, i;
+	u32 end;
+
+	if (!cbm_cons_p)
+		return 0;
+
+	end = MIN(cbm_cons_p->buffer_cursor, cbm_cons_p->buffer_size);
+	if (uart_cursor >= end)
+		return 0;
+
+	/*
+	 * Claim the data before sending it. The UART driver may yield and
+	 * the console may move to CBMEM meanwhile, which rebases the cursor.
+	 */
+	len = MIN(end - uart_cursor, max);
+	data = &cbm_cons_p->buffer_body[uart_cursor];
+	uart_cursor += len;
+
+	for (start = 0; start < len; start = i + 1) {
+		for (i = start; i < len && data[i] != '\n'; i++)
+			;
+		uart_tx_bytes(CONFIG_UART_FOR_CONSOLE, &data[start], i - start);
+		if (i < len)
+			uart_tx_bytes(CONFIG_UART_FOR_CONSOLE, "\r\n", 2);
+	}
+
+	return len;
+}
+
+static void uart_drain_thread(void *unused)
+{
+	const unsigned int byte_usecs = 10 * 1000000 / default_baudrate();
+	size_t sent;
+
+	while (1) {
+		uart_drain_busy = 1;
+		sent = uart_drain(UART_DRAIN_CHUNK);
+		uart_drain_busy = 0;
+
+		if (!sent && uart_drain_stop)
+			break;
+
+		/* Let the FIFO empty before sending the next chunk. */
+		thread_yield_microseconds(sent ? sent * byte_usecs :
+					  UART_DRAIN_IDLE_USECS);
+	}
+}
+
+void cbmemc_drain_uart(void)
+{
+	uart_drain_stop = 1;
+
+	/* Let the drain thread finish the chunk it is sending. */
+	while (uart_drain_busy) {
+		if (thread_yield_microseconds(UART_DRAIN_CHUNK) < 0)
+			break;
+	}
+
+	while (uart_drain(CONFIG_CONSOLE_CBMEM_BUFFER_SIZE))
+		;
+	uart_tx_flush(CONFIG_UART_FOR_CONSOLE);
+}
+
+static void uart_drain_start(void *unused)
+{
+	/* The payload is only started once all output was sent. */
+	if (thread_run_until(uart_drain_thread, NULL, BS_PAYLOAD_BOOT,
+			     BS_ON_ENTRY) < 0)
+		printk(BIOS_ERR, "Console: can't start UART drain thread\n");
+}
+
+static void uart_drain_finish(void *unused)
+{
+	uart_drain_stop = 1;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, uart_drain_start, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, uart_drain_finish, NULL);
+#endif
+
 #if IS_ENABLED(CONFIG_CONSOLE_CBMEM_DUMP_TO_UART)
 void cbmem_dump_console(void)
 {
@@ -23,18 +23,22 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 {
 	struct stage_cache *meta;
 	void *c;
+	size_t data_size;
 
 	meta = cbmem_add(CBMEM_ID_STAGEx_META + stage_id, sizeof(*meta));
 	if (meta == NULL)
 		return;
 	meta->load_addr = (uintptr_t)prog_start(stage);
 	meta->entry_addr = (uintptr_t)prog_entry(stage);
+	meta->mem_size = prog_size(stage);
 
-	c = cbmem_add(CBMEM_ID_STAGEx_CACHE + stage_id, prog_size(stage));
+	data_size = stage_cache_data_size(stage);
+
+	c = cbmem_add(CBMEM_ID_STAGEx_CACHE + stage_id, data_size);
 	if (c == NULL)
 		return;
 
-	memcpy(c, prog_start(stage), prog_size(stage));
+	memcpy(c, prog_start(stage), data_size);
 }
 
 void stage_cache_load_stage(int stage_id, struct prog *stage)
@@ -43,14 +47,16 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 	const struct cbmem_entry *e;
 	void *c;
 	size_t size;
-	void *load_addr;
+	char *load_addr;
 
 	prog_set_entry(stage, NULL, NULL);
 
-	meta = cbmem_find(CBMEM_ID_STAGEx_META + stage_id);
-	if (meta == NULL)
+	e = cbmem_entry_find(CBMEM_ID_STAGEx_META + stage_id);
+	if (e == NULL || cbmem_entry_size(e) != sizeof(*meta))
 		return;
 
+	meta = cbmem_entry_start(e);
+
 	e = cbmem_entry_find(CBMEM_ID_STAGEx_CACHE + stage_id);
 
 	if (e == NULL)
@@ -60,8 +66,13 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 	size = cbmem_entry_size(e);
 	load_addr = (void *)(uintptr_t)meta->load_addr;
 
+	if (size > meta->mem_size)
+		return;
+
+	/* The image is cached as loaded, so no relocation is needed. */
 	memcpy(load_addr, c, size);
+	memset(&load_addr[size], 0, meta->mem_size - size);
 
-	prog_set_area(stage, load_addr, size);
+	prog_set_area(stage, load_addr, meta->mem_size);
 	prog_set_entry(stage, (void *)(uintptr_t)meta->entry_addr, NULL);
 }
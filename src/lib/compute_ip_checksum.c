@@ -1,36 +1,60 @@
 #include <stdint.h>
+#include <string.h>
 #include <ip_checksum.h>
 
 unsigned long compute_ip_checksum(void *addr, unsigned long length)
 {
 	uint8_t *ptr;
-	volatile union {
+	union {
 		uint8_t  byte[2];
 		uint16_t word;
 	} value;
-	unsigned long sum;
-	unsigned long i;
-	/* In the most straight forward way possible,
-	 * compute an ip style checksum.
+	uint64_t sum;
+	uint32_t v32;
+	uint16_t v16;
+
+	/*
+	 * The one's complement sum doesn't depend on the byte order nor on
+	 * the word size used to add up the data (RFC 1071). So sum native
+	 * 32-bit words into a wide accumulator and fold the carries once at
+	 * the end instead of after every byte. Summing native words also
+	 * yields the result in native order, so callers can store it into
+	 * a 16-bit field as is.
 	 */
 	sum = 0;
 	ptr = addr;
-	for(i = 0; i < length; i++) {
-		unsigned long v;
-		v = ptr[i];
-		if (i & 1) {
-			v <<= 8;
-		}
-		/* Add the new value */
-		sum += v;
-		/* Wrap around the carry */
-		if (sum > 0xFFFF) {
-			sum = (sum + (sum >> 16)) & 0xFFFF;
-		}
+	while (length >= 4 * sizeof(v32)) {
+		uint32_t v[4];
+
+		memcpy(v, ptr, sizeof(v));
+		sum += (uint64_t)v[0] + v[1] + v[2] + v[3];
+		ptr += sizeof(v);
+		length -= sizeof(v);
+	}
+	while (length >= sizeof(v32)) {
+		memcpy(&v32, ptr, sizeof(v32));
+		sum += v32;
+		ptr += sizeof(v32);
+		length -= sizeof(v32);
+	}
+	if (length >= sizeof(v16)) {
+		memcpy(&v16, ptr, sizeof(v16));
+		sum += v16;
+		ptr += sizeof(v16);
+		length -= sizeof(v16);
 	}
-	value.byte[0] = sum & 0xff;
-	value.byte[1] = (sum >> 8) & 0xff;
-	return (~value.word) & 0xFFFF;
+	/* A trailing odd byte is the low order byte in memory. */
+	if (length) {
+		value.byte[0] = ptr[0];
+		value.byte[1] = 0;
+		sum += value.word;
+	}
+
+	/* Wrap around the carries */
+	while (sum > 0xFFFF)
+		sum = (sum & 0xFFFF) + (sum >> 16);
+
+	return (~sum) & 0xFFFF;
 }
 
 unsigned long add_ip_checksums(unsigned long offset, unsigned long sum, unsigned long new)
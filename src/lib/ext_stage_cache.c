@@ -64,6 +64,7 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 	const struct imd_entry *e;
 	struct stage_cache *meta;
 	void *c;
+	size_t data_size;
 
 	imd = imd_get();
 	e = imd_entry_add(imd, CBMEM_ID_STAGEx_META + stage_id, sizeof(*meta));
@@ -75,16 +76,19 @@ void stage_cache_add(int stage_id, const struct prog *stage)
 
 	meta->load_addr = (uintptr_t)prog_start(stage);
 	meta->entry_addr = (uintptr_t)prog_entry(stage);
+	meta->mem_size = prog_size(stage);
 
-	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id,
-				prog_size(stage));
+	/* Trailing zeros, i.e. the bss, don't take up external cache space. */
+	data_size = stage_cache_data_size(stage);
+
+	e = imd_entry_add(imd, CBMEM_ID_STAGEx_CACHE + stage_id, data_size);
 
 	if (e == NULL)
 		return;
 
 	c = imd_entry_at(imd, e);
 
-	memcpy(c, prog_start(stage), prog_size(stage));
+	memcpy(c, prog_start(stage), data_size);
 }
 
 void stage_cache_load_stage(int stage_id, struct prog *stage)
@@ -94,10 +98,11 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 	const struct imd_entry *e;
 	void *c;
 	size_t size;
+	char *load_addr;
 
 	imd = imd_get();
 	e = imd_entry_find(imd, CBMEM_ID_STAGEx_META + stage_id);
-	if (e == NULL)
+	if (e == NULL || imd_entry_size(imd, e) != sizeof(*meta))
 		return;
 
 	meta = imd_entry_at(imd, e);
@@ -109,10 +114,16 @@ void stage_cache_load_stage(int stage_id, struct prog *stage)
 
 	c = imd_entry_at(imd, e);
 	size = imd_entry_size(imd, e);
+	load_addr = (void *)(uintptr_t)meta->load_addr;
+
+	if (size > meta->mem_size)
+		return;
 
-	memcpy((void *)(uintptr_t)meta->load_addr, c, size);
+	/* The image is cached as loaded, so no relocation is needed. */
+	memcpy(load_addr, c, size);
+	memset(&load_addr[size], 0, meta->mem_size - size);
 
-	prog_set_area(stage, (void *)(uintptr_t)meta->load_addr, size);
+	prog_set_area(stage, load_addr, meta->mem_size);
 	prog_set_entry(stage, (void *)(uintptr_t)meta->entry_addr, NULL);
 }
 
@@ -29,6 +29,7 @@
 #include <delay.h>
 #include <stdlib.h>
 #include <reset.h>
+#include <span.h>
 #include <boot/tables.h>
 #include <program_loading.h>
 #include <tpm_lite/tlcl.h>
@@ -294,8 +295,12 @@ static void bs_call_callbacks(struct boot_state *state,
 #if IS_ENABLED(CONFIG_DEBUG_BOOT_STATE)
 			printk(BIOS_DEBUG, "BS: callback (%p) @ %s.\n",
 				bscb, bscb->location);
+			span_begin(bscb->location);
 #endif
 			bscb->callback(bscb->arg);
+#if IS_ENABLED(CONFIG_DEBUG_BOOT_STATE)
+			span_end(bscb->location);
+#endif
 			continue;
 		}
 
@@ -343,6 +348,8 @@ static void bs_walk_state_machine(void)
 
 		bs_sample_time(state);
 
+		span_begin(state->name);
+
 		bs_call_callbacks(state, current_phase.seq);
 		/* Update the current sequence so that any calls to block the
 		 * current state from the run_state() function will place a
@@ -363,6 +370,8 @@ static void bs_walk_state_machine(void)
 
 		bs_call_callbacks(state, current_phase.seq);
 
+		span_end(state->name);
+
 		if (IS_ENABLED(CONFIG_DEBUG_BOOT_STATE))
 			printk(BIOS_DEBUG,
 				"----------------------------------------\n");
@@ -16,42 +16,108 @@
 
 #include "lzmadecode.h"
 
-size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+/*
+ * Decode an LZMA stream. The 13 byte header (properties and decompressed
+ * size) is passed separately. The compressed data either is in the src buffer
+ * or, if in is non-NULL, is pulled through the input callback.
+ */
+static size_t ulzma_decode(const unsigned char *header, const void *src,
+			   size_t srcn, ILzmaInCallback *in, void *dst,
+			   void *scratchpad)
 {
-	unsigned char properties[LZMA_PROPERTIES_SIZE];
-	const int data_offset = LZMA_PROPERTIES_SIZE + 8;
 	UInt32 outSize;
 	SizeT inProcessed;
 	SizeT outProcessed;
 	int res;
 	CLzmaDecoderState state;
 	SizeT mallocneeds;
-	MAYBE_STATIC unsigned char scratchpad[15980];
 	const unsigned char *cp;
 
-	memcpy(properties, src, LZMA_PROPERTIES_SIZE);
 	/* The outSize in LZMA stream is a 64bit integer stored in little-endian
 	 * (ref: lzma.cc@LZMACompress: put_64). To prevent accessing by
 	 * unaligned memory address and to load in correct endianness, read each
 	 * byte and re-construct. */
-	cp = src + LZMA_PROPERTIES_SIZE;
+	cp = header + LZMA_PROPERTIES_SIZE;
 	outSize = cp[3] << 24 | cp[2] << 16 | cp[1] << 8 | cp[0];
-	if (LzmaDecodeProperties(&state.Properties, properties,
+	if (LzmaDecodeProperties(&state.Properties, header,
 				 LZMA_PROPERTIES_SIZE) != LZMA_RESULT_OK) {
 		printk(BIOS_WARNING, "lzma: Incorrect stream properties.\n");
 		return 0;
 	}
 	mallocneeds = (LzmaGetNumProbs(&state.Properties) * sizeof(CProb));
-	if (mallocneeds > 15980) {
+	if (mallocneeds > ULZMA_SCRATCH_SIZE) {
 		printk(BIOS_WARNING, "lzma: Decoder scratchpad too small!\n");
 		return 0;
 	}
 	state.Probs = (CProb *)scratchpad;
-	res = LzmaDecode(&state, src + data_offset, srcn - data_offset,
-			 &inProcessed, dst, outSize, &outProcessed);
+	state.InCallback = in;
+	res = LzmaDecode(&state, src, srcn, &inProcessed, dst, outSize,
+			 &outProcessed);
 	if (res != 0) {
 		printk(BIOS_WARNING, "lzma: Decoding error = %d\n", res);
 		return 0;
 	}
 	return outProcessed;
 }
+
+size_t ulzma_with_scratch(const void *src, size_t srcn, void *dst,
+			  size_t dstn, void *scratchpad)
+{
+	const int data_offset = LZMA_PROPERTIES_SIZE + 8;
+
+	return ulzma_decode(src, src + data_offset, srcn - data_offset, NULL,
+			    dst, scratchpad);
+}
+
+size_t ulzman(const void *src, size_t srcn, void *dst, size_t dstn)
+{
+	MAYBE_STATIC unsigned char scratchpad[ULZMA_SCRATCH_SIZE];
+
+	return ulzma_with_scratch(src, srcn, dst, dstn, scratchpad);
+}
+
+/* Input window for streaming decompression. */
+#define ULZMA_STREAM_WINDOW 512
+
+struct ulzma_stream {
+	/* Needs to be first, the decoder passes it back to the callback. */
+	ILzmaInCallback cb;
+	size_t (*read)(void *arg, void *buf, size_t size);
+	void *arg;
+	/* Aligned so the decoder can use 32-bit reads. */
+	unsigned char buf[ULZMA_STREAM_WINDOW] __attribute__((aligned(4)));
+};
+
+static int ulzma_stream_read(void *object, const unsigned char **buffer,
+			     SizeT *size)
+{
+	struct ulzma_stream *s = object;
+
+	*buffer = s->buf;
+	*size = s->read(s->arg, s->buf, sizeof(s->buf));
+
+	return *size ? 0 : -1;
+}
+
+size_t ulzman_stream(size_t (*read)(void *arg, void *buf, size_t size),
+		     void *arg, void *dst, size_t dstn)
+{
+	MAYBE_STATIC unsigned char scratchpad[ULZMA_SCRATCH_SIZE];
+	unsigned char header[LZMA_PROPERTIES_SIZE + 8];
+	size_t got = 0;
+	size_t n;
+	struct ulzma_stream s = {
+		.cb = { .Read = ulzma_stream_read },
+		.read = read,
+		.arg = arg,
+	};
+
+	while (got < sizeof(header)) {
+		n = read(arg, header + got, sizeof(header) - got);
+		if (n == 0)
+			return 0;
+		got += n;
+	}
+
+	return ulzma_decode(header, NULL, 0, &s.cb, dst, scratchpad);
+}
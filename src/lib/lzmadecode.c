@@ -41,7 +41,13 @@
   { int i; for(i = 0; i < 5; i++) { RC_TEST; Code = (Code << 8) | RC_READ_BYTE; }}
 
 
-#define RC_TEST { if (Buffer == BufferLim) return LZMA_RESULT_DATA_ERROR; }
+#define RC_TEST { if (Buffer == BufferLim) { \
+  SizeT inChunk; \
+  if (vs->InCallback == 0 || \
+      vs->InCallback->Read(vs->InCallback, &Buffer, &inChunk) || \
+      inChunk == 0) \
+    return LZMA_RESULT_DATA_ERROR; \
+  BufferLim = Buffer + inChunk; }}
 
 #define RC_INIT(buffer, bufferSize) Buffer = buffer; BufferLim = buffer + bufferSize; RC_INIT2
 
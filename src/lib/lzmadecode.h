@@ -51,10 +51,21 @@ int LzmaDecodeProperties(CLzmaProperties *propsRes, const unsigned char *propsDa
 
 #define kLzmaNeedInitId (-2)
 
+/* Optional input callback. Read() is called once the current input buffer
+ * is exhausted and has to point *buffer to the next chunk of input and set
+ * *bufferSize accordingly. Returns 0 on success. */
+typedef struct _ILzmaInCallback
+{
+  int (*Read)(void *object, const unsigned char **buffer, SizeT *bufferSize);
+} ILzmaInCallback;
+
 typedef struct _CLzmaDecoderState
 {
   CLzmaProperties Properties;
   CProb *Probs;
+  /* When set, inStream/inSize of LzmaDecode() are ignored and all input is
+   * pulled through the callback. inSizeProcessed is meaningless then. */
+  ILzmaInCallback *InCallback;
 
 
 } CLzmaDecoderState;
@@ -1,4 +1,7 @@
 #include <stdlib.h>
+#include <string.h>
+#include <bootstate.h>
+#include <cbmem.h>
 #include <console/console.h>
 #include <cpu/x86/smm.h>
 
@@ -9,6 +12,9 @@
 #endif
 
 extern unsigned char _heap, _eheap;
+
+#if !IS_ENABLED(CONFIG_HEAP_FREELIST)
+
 static void *free_mem_ptr = &_heap;		/* Start of heap */
 static void *free_mem_end_ptr = &_eheap;	/* End of heap */
 
@@ -42,6 +48,260 @@ void *memalign(size_t boundary, size_t size)
 	return p;
 }
 
+#else /* CONFIG_HEAP_FREELIST */
+
+/*
+ * First-fit free-list allocator. Every block, used or free, starts with a
+ * heap_block header. Free blocks are kept on a singly linked list sorted by
+ * address so that neighbouring free blocks can be merged when freeing.
+ */
+struct heap_block {
+	/* Size of the block including this header. */
+	size_t size;
+	size_t magic;
+};
+
+struct free_block {
+	struct heap_block hdr;
+	struct free_block *next;
+};
+
+#define HEAP_MAGIC_USED	0x48454150
+#define HEAP_MAGIC_FREE	0x46524545
+#define HEAP_ALIGN	sizeof(u64)
+#define HDR_SIZE	ALIGN(sizeof(struct heap_block), HEAP_ALIGN)
+#define MIN_BLOCK_SIZE	ALIGN(sizeof(struct free_block), HEAP_ALIGN)
+
+struct heap_stats {
+	uint64_t heap_size;
+	uint64_t in_use;
+	uint64_t high_water;
+	uint32_t allocations;
+	uint32_t frees;
+} __attribute__((packed));
+
+static struct free_block *free_list;
+static int heap_initialized;
+static struct heap_stats stats;
+
+static void heap_init(void)
+{
+	struct free_block *b;
+	uintptr_t start = ALIGN((uintptr_t)&_heap, HEAP_ALIGN);
+	uintptr_t end = ALIGN_DOWN((uintptr_t)&_eheap, HEAP_ALIGN);
+
+	b = (struct free_block *)start;
+	b->hdr.size = end - start;
+	b->hdr.magic = HEAP_MAGIC_FREE;
+	b->next = NULL;
+
+	free_list = b;
+	stats.heap_size = end - start;
+	heap_initialized = 1;
+}
+
+/* Insert a free block into the list, merging it with its neighbours. */
+static void free_list_insert(struct free_block *b)
+{
+	struct free_block *prev = NULL;
+	struct free_block *next = free_list;
+
+	while (next != NULL && next < b) {
+		prev = next;
+		next = next->next;
+	}
+
+	b->hdr.magic = HEAP_MAGIC_FREE;
+	b->next = next;
+
+	if (next != NULL && (uintptr_t)b + b->hdr.size == (uintptr_t)next) {
+		b->hdr.size += next->hdr.size;
+		b->next = next->next;
+	}
+
+	if (prev == NULL) {
+		free_list = b;
+		return;
+	}
+
+	if ((uintptr_t)prev + prev->hdr.size == (uintptr_t)b) {
+		prev->hdr.size += b->hdr.size;
+		prev->next = b->next;
+	} else {
+		prev->next = b;
+	}
+}
+
+/*
+ * Try to carve a block of size bytes whose payload is aligned to boundary
+ * out of the free block b. Returns the payload address or NULL.
+ */
+static void *carve_block(struct free_block *b, struct free_block **link,
+			 size_t boundary, size_t size)
+{
+	uintptr_t start = (uintptr_t)b;
+	uintptr_t end = start + b->hdr.size;
+	uintptr_t payload;
+	uintptr_t lead;
+	struct heap_block *used;
+
+	payload = ALIGN(start + HDR_SIZE, boundary);
+	lead = payload - HDR_SIZE - start;
+
+	/* A leading fragment has to be large enough to be a free block. */
+	if (lead != 0 && lead < MIN_BLOCK_SIZE) {
+		payload = ALIGN(start + MIN_BLOCK_SIZE + HDR_SIZE, boundary);
+		lead = payload - HDR_SIZE - start;
+	}
+
+	if (payload + size > end)
+		return NULL;
+
+	/* Unlink the block, the remaining fragments are put back below. */
+	*link = b->next;
+
+	used = (struct heap_block *)(payload - HDR_SIZE);
+	used->size = size + HDR_SIZE;
+	used->magic = HEAP_MAGIC_USED;
+
+	if (end - (payload + size) >= MIN_BLOCK_SIZE) {
+		struct free_block *tail = (void *)(payload + size);
+
+		tail->hdr.size = end - (payload + size);
+		free_list_insert(tail);
+	} else {
+		used->size = end - (uintptr_t)used;
+	}
+
+	if (lead != 0) {
+		b->hdr.size = lead;
+		free_list_insert(b);
+	}
+
+	return (void *)payload;
+}
+
+void *memalign(size_t boundary, size_t size)
+{
+	struct free_block **link;
+	void *p = NULL;
+
+	MALLOCDBG("%s Enter, boundary %zu, size %zu\n", __func__, boundary,
+		size);
+
+	if (!heap_initialized)
+		heap_init();
+
+	if (boundary < HEAP_ALIGN)
+		boundary = HEAP_ALIGN;
+	/* Keep enough room to turn the block into a free block later. */
+	size = ALIGN(MAX(size, MIN_BLOCK_SIZE - HDR_SIZE), HEAP_ALIGN);
+
+	for (link = &free_list; *link != NULL; link = &(*link)->next) {
+		p = carve_block(*link, link, boundary, size);
+		if (p != NULL)
+			break;
+	}
+
+	if (p == NULL) {
+		printk(BIOS_ERR, "memalign(boundary=%zu, size=%zu): failed: ",
+				boundary, size);
+		printk(BIOS_ERR, "%llu of %llu bytes in use\n", stats.in_use,
+				stats.heap_size);
+		die("Error! memalign: Out of memory");
+	}
+
+	stats.allocations++;
+	stats.in_use += ((struct heap_block *)(p - HDR_SIZE))->size;
+	if (stats.in_use > stats.high_water)
+		stats.high_water = stats.in_use;
+
+	MALLOCDBG("memalign %p\n", p);
+
+	return p;
+}
+
+static struct heap_block *heap_block_of(void *ptr)
+{
+	struct heap_block *b = ptr - HDR_SIZE;
+
+	if ((unsigned char *)b < &_heap || (unsigned char *)ptr >= &_eheap ||
+	    b->magic != HEAP_MAGIC_USED) {
+		printk(BIOS_ERR, "%s: %p is not an allocated block\n",
+			__func__, ptr);
+		return NULL;
+	}
+
+	return b;
+}
+
+void free(void *ptr)
+{
+	struct heap_block *b;
+
+	if (ptr == NULL)
+		return;
+
+	MALLOCDBG("free %p\n", ptr);
+
+	b = heap_block_of(ptr);
+	if (b == NULL)
+		return;
+
+	stats.frees++;
+	stats.in_use -= b->size;
+
+	free_list_insert((struct free_block *)b);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	struct heap_block *b;
+	void *p;
+
+	if (ptr == NULL)
+		return malloc(size);
+
+	if (size == 0) {
+		free(ptr);
+		return NULL;
+	}
+
+	b = heap_block_of(ptr);
+	if (b == NULL)
+		return NULL;
+
+	/* Shrinking, or growing within the slack of the block. */
+	if (size <= b->size - HDR_SIZE)
+		return ptr;
+
+	p = malloc(size);
+	memcpy(p, ptr, b->size - HDR_SIZE);
+	free(ptr);
+
+	return p;
+}
+
+#if ENV_RAMSTAGE
+static void heap_report(void *unused)
+{
+	struct heap_stats *cbmem_stats;
+
+	printk(BIOS_DEBUG, "Heap: %llu of %llu bytes in use, high water mark "
+		"%llu, %u allocations, %u frees\n", stats.in_use,
+		stats.heap_size, stats.high_water, stats.allocations,
+		stats.frees);
+
+	cbmem_stats = cbmem_add(CBMEM_ID_HEAP_STATS, sizeof(stats));
+	if (cbmem_stats != NULL)
+		memcpy(cbmem_stats, &stats, sizeof(stats));
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, heap_report, NULL);
+#endif
+
+#endif /* CONFIG_HEAP_FREELIST */
+
 void *malloc(size_t size)
 {
 	return memalign(sizeof(u64), size);
@@ -1,12 +1,53 @@
 #include <string.h>
+#include <stdint.h>
+
+/* Word type which is allowed to alias any object it is used to copy. */
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+#define WSIZE sizeof(word_t)
+#define WMASK (WSIZE - 1)
+
 void *memcpy(void *vdest, const void *vsrc, size_t bytes)
 {
 	const char *src = vsrc;
 	char *dest = vdest;
-	int i;
 
-	for (i = 0; i < (int)bytes; i++)
-		dest[i] = src[i];
+	/* Word accesses are only possible when both pointers can be aligned
+	 * at the same time. Otherwise fall back to copying bytes. */
+	if (bytes >= WSIZE &&
+	    (((uintptr_t)src ^ (uintptr_t)dest) & WMASK) == 0) {
+		const word_t *wsrc;
+		word_t *wdest;
+
+		while ((uintptr_t)dest & WMASK) {
+			*dest++ = *src++;
+			bytes--;
+		}
+
+		wsrc = (const word_t *)src;
+		wdest = (word_t *)dest;
+
+		while (bytes >= 4 * WSIZE) {
+			wdest[0] = wsrc[0];
+			wdest[1] = wsrc[1];
+			wdest[2] = wsrc[2];
+			wdest[3] = wsrc[3];
+			wsrc += 4;
+			wdest += 4;
+			bytes -= 4 * WSIZE;
+		}
+
+		while (bytes >= WSIZE) {
+			*wdest++ = *wsrc++;
+			bytes -= WSIZE;
+		}
+
+		src = (const char *)wsrc;
+		dest = (char *)wdest;
+	}
+
+	while (bytes--)
+		*dest++ = *src++;
 
 	return vdest;
 }
@@ -1,18 +1,64 @@
 #include <string.h>
+#include <stdint.h>
+
+/* Word type which is allowed to alias any object it is used to copy. */
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+#define WSIZE sizeof(word_t)
+#define WMASK (WSIZE - 1)
+
 void *memmove(void *vdest, const void *vsrc, size_t count)
 {
 	const char *src = vsrc;
 	char *dest = vdest;
+	const int aligned =
+		(((uintptr_t)src ^ (uintptr_t)dest) & WMASK) == 0;
 
 	if (dest <= src) {
+		if (aligned && count >= WSIZE) {
+			const word_t *wsrc;
+			word_t *wdest;
+
+			while ((uintptr_t)dest & WMASK) {
+				*dest++ = *src++;
+				count--;
+			}
+
+			wsrc = (const word_t *)src;
+			wdest = (word_t *)dest;
+			while (count >= WSIZE) {
+				*wdest++ = *wsrc++;
+				count -= WSIZE;
+			}
+			src = (const char *)wsrc;
+			dest = (char *)wdest;
+		}
 		while (count--) {
 			*dest++ = *src++;
 		}
 	} else {
-		src  += count - 1;
-		dest += count - 1;
+		src  += count;
+		dest += count;
+		if (aligned && count >= WSIZE) {
+			const word_t *wsrc;
+			word_t *wdest;
+
+			while ((uintptr_t)dest & WMASK) {
+				*--dest = *--src;
+				count--;
+			}
+
+			wsrc = (const word_t *)src;
+			wdest = (word_t *)dest;
+			while (count >= WSIZE) {
+				*--wdest = *--wsrc;
+				count -= WSIZE;
+			}
+			src = (const char *)wsrc;
+			dest = (char *)wdest;
+		}
 		while(count--) {
-			*dest-- = *src--;
+			*--dest = *--src;
 		}
 	}
 	return vdest;
@@ -1,12 +1,50 @@
 #include <string.h>
+#include <stdint.h>
+
+/* Word type which is allowed to alias any object it is used to fill. */
+typedef unsigned long __attribute__((may_alias)) word_t;
+
+#define WSIZE sizeof(word_t)
+#define WMASK (WSIZE - 1)
 
 void *memset(void *s, int c, size_t n)
 {
-	int i;
 	char *ss = (char *) s;
 
-	for (i = 0; i < (int)n; i++)
-		ss[i] = c;
+	if (n >= WSIZE) {
+		word_t *ws;
+		word_t w;
+
+		while ((uintptr_t)ss & WMASK) {
+			*ss++ = c;
+			n--;
+		}
+
+		/* Replicate the fill byte into every byte of the word. */
+		w = (unsigned char)c;
+		w *= (word_t)-1 / 0xff;
+
+		ws = (word_t *)ss;
+
+		while (n >= 4 * WSIZE) {
+			ws[0] = w;
+			ws[1] = w;
+			ws[2] = w;
+			ws[3] = w;
+			ws += 4;
+			n -= 4 * WSIZE;
+		}
+
+		while (n >= WSIZE) {
+			*ws++ = w;
+			n -= WSIZE;
+		}
+
+		ss = (char *)ws;
+	}
+
+	while (n--)
+		*ss++ = c;
 
 	return s;
 }
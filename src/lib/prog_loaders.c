@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <cbfs.h>
 #include <cbmem.h>
+#include <console/cbmem_console.h>
 #include <console/console.h>
 #include <fallback.h>
 #include <halt.h>
@@ -188,6 +189,8 @@ void payload_run(void)
 	 */
 	checkstack(_estack, 0);
 
+	cbmemc_drain_uart();
+
 	prog_run(payload);
 }
 
@@ -28,6 +28,12 @@
 #include <bootmem.h>
 #include <program_loading.h>
 #include <timestamp.h>
+#if IS_ENABLED(CONFIG_PAYLOAD_PARALLEL_DECOMPRESS)
+#include <bootstate.h>
+#include <cbmem.h>
+#include <cpu/x86/mp.h>
+#include <smp/spinlock.h>
+#endif
 
 static const unsigned long lb_start = (unsigned long)&_program;
 static const unsigned long lb_end = (unsigned long)&_eprogram;
@@ -40,6 +46,8 @@ struct segment {
 	unsigned long s_memsz;
 	unsigned long s_filesz;
 	int compression;
+	/* Set once the segment was decompressed ahead of the serial loop. */
+	int preloaded;
 };
 
 static void segment_insert_before(struct segment *seg, struct segment *new)
@@ -269,6 +277,7 @@ static int build_self_segment_list(
 			new->s_dstaddr = segment.load_addr;
 			new->s_memsz = segment.mem_len;
 			new->compression = segment.compression;
+			new->preloaded = 0;
 			new->s_srcaddr = (uintptr_t)
 				((unsigned char *)first_segment)
 				+ segment.offset;
@@ -298,6 +307,7 @@ static int build_self_segment_list(
 			new->s_dstaddr = segment.load_addr;
 			new->s_memsz = segment.mem_len;
 			new->compression = CBFS_COMPRESS_NONE;
+			new->preloaded = 0;
 			break;
 
 		case PAYLOAD_SEGMENT_ENTRY:
@@ -358,6 +368,217 @@ static int payload_targets_usable_ram(struct segment *head)
 	return 1;
 }
 
+/*
+ * Parallel decompression of payload segments. Compressed segments which
+ * neither overlap coreboot, the bounce buffer nor any other segment don't
+ * depend on the loading order. Those are decompressed up front by the BSP
+ * and all APs which are available for work, each taking the next pending
+ * segment from the list until none are left.
+ */
+#if IS_ENABLED(CONFIG_PAYLOAD_PARALLEL_DECOMPRESS)
+#define MAX_PRELOAD_SEGMENTS 32
+
+struct preload_job {
+	struct segment *seg;
+	int ok;
+};
+
+static struct preload_job preload_jobs[MAX_PRELOAD_SEGMENTS];
+
+/*
+ * Every LZMA decompression in flight needs its own decoder state. The APs
+ * only have a small stack, so the buffers are taken from a CBMEM entry sized
+ * for the number of CPUs which take work, and handed out from a free list.
+ * The entry is added before the tables are written, so the memory map
+ * reports it as reserved and no payload segment may target it.
+ */
+DECLARE_SPIN_LOCK(scratch_lock)
+static unsigned char *scratch_free[MAX_PRELOAD_SEGMENTS];
+static int scratch_num_free;
+
+static void scratch_reserve(void *unused)
+{
+	size_t num_scratch;
+
+	if (mp_get_ap_count() == 0)
+		return;
+
+	num_scratch = MIN(MAX_PRELOAD_SEGMENTS, mp_get_ap_count() + 1);
+	if (cbmem_add(CBMEM_ID_LZMA_SCRATCH,
+		      num_scratch * ULZMA_SCRATCH_SIZE) == NULL)
+		printk(BIOS_ERR, "Could not reserve LZMA scratch space.\n");
+}
+
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, scratch_reserve, NULL);
+
+static unsigned char *scratch_get(void)
+{
+	unsigned char *scratch = NULL;
+
+	spin_lock(&scratch_lock);
+	if (scratch_num_free > 0)
+		scratch = scratch_free[--scratch_num_free];
+	spin_unlock(&scratch_lock);
+
+	return scratch;
+}
+
+static void scratch_put(unsigned char *scratch)
+{
+	spin_lock(&scratch_lock);
+	scratch_free[scratch_num_free++] = scratch;
+	spin_unlock(&scratch_lock);
+}
+
+static int ranges_overlap(unsigned long a_start, unsigned long a_size,
+			  unsigned long b_start, unsigned long b_size)
+{
+	return !((a_start + a_size <= b_start) || (a_start >= b_start + b_size));
+}
+
+static int segment_is_independent(struct segment *head, struct segment *seg,
+				  const struct cbmem_entry *scratch_entry)
+{
+	struct segment *ptr;
+
+	if (seg->compression != CBFS_COMPRESS_LZMA &&
+	    seg->compression != CBFS_COMPRESS_LZ4)
+		return 0;
+
+	if (overlaps_coreboot(seg))
+		return 0;
+
+	if (ranges_overlap(seg->s_dstaddr, seg->s_memsz, bounce_buffer,
+			   bounce_size))
+		return 0;
+
+	/* The serial loop only runs once all decoders are done with it. */
+	if (scratch_entry != NULL &&
+	    ranges_overlap(seg->s_dstaddr, seg->s_memsz,
+			   (uintptr_t)cbmem_entry_start(scratch_entry),
+			   cbmem_entry_size(scratch_entry)))
+		return 0;
+
+	for (ptr = head->next; ptr != head; ptr = ptr->next) {
+		if (ptr == seg)
+			continue;
+		if (ranges_overlap(seg->s_dstaddr, seg->s_memsz,
+				   ptr->s_dstaddr, ptr->s_memsz))
+			return 0;
+		/* Don't clobber the compressed data of any segment. */
+		if (ranges_overlap(seg->s_dstaddr, seg->s_memsz,
+				   ptr->s_srcaddr, ptr->s_filesz))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int preload_segment(struct segment *seg, void *lzma_scratch)
+{
+	unsigned char *dest = (unsigned char *)seg->s_dstaddr;
+	const void *src = (const void *)seg->s_srcaddr;
+	size_t len;
+
+	if (seg->compression == CBFS_COMPRESS_LZMA)
+		len = ulzma_with_scratch(src, seg->s_filesz, dest,
+					 seg->s_memsz, lzma_scratch);
+	else
+		len = ulz4fn(src, seg->s_filesz, dest, seg->s_memsz);
+
+	if (!len)
+		return 0;
+
+	if (len < seg->s_memsz)
+		memset(dest + len, 0, seg->s_memsz - len);
+
+	return 1;
+}
+
+static void preload_worker(void *arg, int index)
+{
+	struct preload_job *job = &preload_jobs[index];
+	unsigned char *scratch = NULL;
+
+	if (job->seg->compression == CBFS_COMPRESS_LZMA) {
+		scratch = scratch_get();
+		/* Not expected, but the serial loop would load it. */
+		if (scratch == NULL)
+			return;
+	}
+
+	job->ok = preload_segment(job->seg, scratch);
+
+	if (scratch != NULL)
+		scratch_put(scratch);
+}
+
+static void preload_self_segments(struct segment *head)
+{
+	struct segment *ptr;
+	const struct cbmem_entry *scratch_entry;
+	unsigned char *scratch;
+	int num_jobs;
+	int num_lzma;
+	int num_scratch;
+	int num_cpus;
+	int i;
+
+	if (mp_get_ap_count() == 0)
+		return;
+
+	scratch_entry = cbmem_entry_find(CBMEM_ID_LZMA_SCRATCH);
+
+	num_jobs = 0;
+	num_lzma = 0;
+	for (ptr = head->next; ptr != head; ptr = ptr->next) {
+		if (num_jobs == ARRAY_SIZE(preload_jobs))
+			break;
+		if (!segment_is_independent(head, ptr, scratch_entry))
+			continue;
+		preload_jobs[num_jobs].seg = ptr;
+		preload_jobs[num_jobs].ok = 0;
+		num_jobs++;
+		if (ptr->compression == CBFS_COMPRESS_LZMA)
+			num_lzma++;
+	}
+
+	/* Not worth waking up the APs for a single segment. */
+	if (num_jobs < 2)
+		return;
+
+	/* No more LZMA decompressions can run at once than there are CPUs. */
+	num_scratch = 0;
+	if (num_lzma > 0) {
+		if (scratch_entry == NULL)
+			return;
+		num_scratch = MIN(num_lzma,
+				  (size_t)cbmem_entry_size(scratch_entry) /
+				  ULZMA_SCRATCH_SIZE);
+	}
+	scratch_num_free = 0;
+	if (num_scratch > 0) {
+		scratch = cbmem_entry_start(scratch_entry);
+		for (i = 0; i < num_scratch; i++)
+			scratch_free[scratch_num_free++] =
+				&scratch[i * ULZMA_SCRATCH_SIZE];
+	}
+
+	timestamp_add_now(TS_START_ULZMA);
+	num_cpus = mp_run_queue(preload_worker, NULL, num_jobs);
+	timestamp_add_now(TS_END_ULZMA);
+
+	printk(BIOS_DEBUG, "Decompressed %d segments on %d CPUs\n",
+		num_jobs, num_cpus);
+
+	/* Failed segments are simply loaded again by the serial loop. */
+	for (i = 0; i < num_jobs; i++)
+		preload_jobs[i].seg->preloaded = preload_jobs[i].ok;
+}
+#else
+static void preload_self_segments(struct segment *head) {}
+#endif
+
 static int load_self_segments(struct segment *head, struct prog *payload,
 			      bool check_regions)
 {
@@ -391,12 +612,21 @@ static int load_self_segments(struct segment *head, struct prog *payload,
 		return 0;
 	}
 
+	preload_self_segments(head);
+
 	for(ptr = head->next; ptr != head; ptr = ptr->next) {
 		unsigned char *dest, *src, *middle, *end;
 		size_t len, memsz;
 		printk(BIOS_DEBUG, "Loading Segment: addr: 0x%016lx memsz: 0x%016lx filesz: 0x%016lx\n",
 			ptr->s_dstaddr, ptr->s_memsz, ptr->s_filesz);
 
+		if (ptr->preloaded) {
+			printk(BIOS_DEBUG, "already decompressed\n");
+			prog_segment_loaded(ptr->s_dstaddr, ptr->s_memsz,
+					ptr->next == head ? SEG_FINAL : 0);
+			continue;
+		}
+
 		/* Modify the segment to load onto the bounce_buffer if necessary.
 		 */
 		if (relocate_segment(bounce_buffer, ptr)) {
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <cbmem.h>
+#include <console/console.h>
+#include <smp/node.h>
+#include <span.h>
+#include <string.h>
+#include <timestamp.h>
+
+/* Number of events kept in BSS until cbmem comes online. */
+#define SPAN_CACHE_EVENTS 32
+
+static struct {
+	struct span_buffer buf;
+	/* Storage for the events of the buffer above. */
+	struct span_event events[SPAN_CACHE_EVENTS];
+} span_cache = {
+	.buf.max_events = SPAN_CACHE_EVENTS,
+};
+
+static struct span_buffer *span_buf = &span_cache.buf;
+static uint8_t span_depth;
+
+static void span_buffer_add(struct span_buffer *buf, uint8_t type,
+			    uint8_t depth, uint64_t stamp, const char *name)
+{
+	struct span_event *e;
+
+	e = &buf->events[buf->num_events % buf->max_events];
+	buf->num_events++;
+
+	e->stamp = stamp;
+	e->type = type;
+	e->depth = depth;
+	strncpy(e->name, name, sizeof(e->name) - 1);
+	e->name[sizeof(e->name) - 1] = '\0';
+}
+
+static void span_add(uint8_t type, const char *name)
+{
+	uint8_t depth;
+
+	if (IS_ENABLED(CONFIG_ARCH_X86) && !boot_cpu())
+		return;
+
+	if (type == SPAN_BEGIN) {
+		depth = span_depth++;
+	} else {
+		if (span_depth == 0) {
+			printk(BIOS_WARNING, "span: Unbalanced end of %s\n",
+			       name);
+			return;
+		}
+		depth = --span_depth;
+	}
+
+	span_buffer_add(span_buf, type, depth, timestamp_get(), name);
+}
+
+void span_begin(const char *name)
+{
+	span_add(SPAN_BEGIN, name);
+}
+
+void span_end(const char *name)
+{
+	span_add(SPAN_END, name);
+}
+
+static void span_sync_cache_to_cbmem(int is_recovery)
+{
+	struct span_buffer *buf;
+	uint32_t i;
+	uint32_t first = 0;
+
+	buf = cbmem_add(CBMEM_ID_SPANS, sizeof(*buf) +
+			CONFIG_BOOT_SPANS_EVENTS * sizeof(buf->events[0]));
+	if (buf == NULL) {
+		printk(BIOS_ERR, "ERROR: No span buffer allocated\n");
+		return;
+	}
+
+	/* A buffer recovered from a previous boot is simply overwritten. */
+	buf->max_events = CONFIG_BOOT_SPANS_EVENTS;
+	buf->num_events = 0;
+	buf->tick_freq_mhz = timestamp_tick_freq_mhz();
+	buf->reserved = 0;
+
+	/* Replay the cached events, oldest first. */
+	if (span_cache.buf.num_events > SPAN_CACHE_EVENTS)
+		first = span_cache.buf.num_events - SPAN_CACHE_EVENTS;
+
+	for (i = first; i < span_cache.buf.num_events; i++) {
+		struct span_event *e = &span_cache.events[i % SPAN_CACHE_EVENTS];
+
+		span_buffer_add(buf, e->type, e->depth, e->stamp, e->name);
+	}
+
+	span_buf = buf;
+}
+
+RAMSTAGE_CBMEM_INIT_HOOK(span_sync_cache_to_cbmem)
@@ -51,6 +51,18 @@ static int is_mrc_cache(struct mrc_data_container *mrc_cache)
 	return (!!mrc_cache) && (mrc_cache->mrc_signature == MRC_DATA_SIGNATURE);
 }
 
+/* A torn header must not make us checksum or skip past the region end. */
+static int mrc_block_in_region(struct mrc_data_container *mrc_cache,
+			       u32 region_end)
+{
+	u32 data_start = (u32)mrc_cache + sizeof(*mrc_cache);
+
+	if (data_start > region_end)
+		return 0;
+
+	return mrc_cache->mrc_data_size <= region_end - data_start;
+}
+
 /* Right now, the offsets for the MRC cache area are hard-coded in the
  * northbridge Kconfig if CONFIG_CHROMEOS is not set. In order to make
  * this more flexible, there are two of options:
@@ -90,8 +102,12 @@ static struct mrc_data_container *find_current_mrc_cache_local
 
 	region_end = (u32) mrc_cache + region_size;
 
-	/* Search for the last filled entry in the region */
-	while (is_mrc_cache(mrc_next)) {
+	/*
+	 * Search for the last filled entry in the region. Only the headers
+	 * are looked at; the checksum is verified for the picked entry only.
+	 */
+	while (is_mrc_cache(mrc_next) &&
+	       mrc_block_in_region(mrc_next, region_end)) {
 		entry_id++;
 		mrc_cache = mrc_next;
 		mrc_next = next_mrc_block(mrc_next);
@@ -88,17 +88,26 @@ static int mrc_cache_in_region(const struct mrc_data_region *region,
 	return 1;
 }
 
-static int mrc_cache_valid(const struct mrc_data_region *region,
-                           const struct mrc_saved_data *cache)
+static int mrc_cache_header_valid(const struct mrc_data_region *region,
+                                  const struct mrc_saved_data *cache)
 {
-	uint32_t checksum;
-
 	if (cache->signature != MRC_DATA_SIGNATURE)
 		return 0;
 
 	if (cache->size > region->size)
 		return 0;
 
+	return 1;
+}
+
+static int mrc_cache_valid(const struct mrc_data_region *region,
+                           const struct mrc_saved_data *cache)
+{
+	uint32_t checksum;
+
+	if (!mrc_cache_header_valid(region, cache))
+		return 0;
+
 	checksum = compute_ip_checksum((void *)&cache->data[0], cache->size);
 
 	if (cache->checksum != checksum)
@@ -117,43 +126,90 @@ next_cache_block(const struct mrc_saved_data *cache)
 	return (const struct mrc_saved_data *)next;
 }
 
-/* Locate the most recently saved MRC data. */
+/*
+ * Find the last slot in front of end whose data passes its checksum. Only
+ * used when the most recent slot turns out to be corrupt.
+ */
+static const struct mrc_saved_data *
+mrc_cache_last_valid_before(const struct mrc_data_region *region,
+                            const struct mrc_saved_data *end, int *slot)
+{
+	const struct mrc_saved_data *msd;
+	const struct mrc_saved_data *verified_cache;
+	int i;
+
+	msd = region->base;
+	verified_cache = NULL;
+
+	for (i = 0; msd != end; i++) {
+		if (mrc_cache_valid(region, msd)) {
+			verified_cache = msd;
+			*slot = i;
+		}
+		msd = next_cache_block(msd);
+	}
+
+	return verified_cache;
+}
+
+/*
+ * Locate the most recently saved MRC data. If corrupt isn't NULL, it is set
+ * when the last slot was corrupt and an older one had to be used instead.
+ */
 static int __mrc_cache_get_current(const struct mrc_data_region *region,
                                    const struct mrc_saved_data **cache,
-                                   uint32_t version)
+                                   uint32_t version, int *corrupt)
 {
 	const struct mrc_saved_data *msd;
-	const struct mrc_saved_data *verified_cache;
-	int slot = 0;
+	const struct mrc_saved_data *latest;
+	int slot = -1;
 
 	msd = region->base;
 
-	verified_cache = NULL;
+	latest = NULL;
 
+	if (corrupt != NULL)
+		*corrupt = 0;
+
+	/*
+	 * Slots are only ever appended until the region is erased, so the
+	 * most recently saved data is in the last slot with a valid header.
+	 * Only the headers are walked; the stale copies in front of it are
+	 * never used and don't need their payload checksummed, unless the
+	 * last one is corrupt and we have to fall back to an older copy.
+	 */
 	while (mrc_cache_in_region(region, msd) &&
-	       mrc_cache_valid(region, msd)) {
-		verified_cache = msd;
+	       mrc_cache_header_valid(region, msd)) {
+		latest = msd;
 		msd = next_cache_block(msd);
 		slot++;
 	}
 
+	if (latest != NULL && !mrc_cache_valid(region, latest)) {
+		printk(BIOS_DEBUG, "MRC cache slot %d @ %p checksum mismatch\n",
+			slot, latest);
+		latest = mrc_cache_last_valid_before(region, latest, &slot);
+		if (corrupt != NULL)
+			*corrupt = 1;
+	}
+
 	/*
 	 * Update pointer to the most recently saved MRC data before returning
 	 * any error. This ensures that the caller can use next available slot
 	 * if required.
 	 */
-	*cache = verified_cache;
+	*cache = latest;
 
-	if (verified_cache == NULL)
+	if (latest == NULL)
 		return -1;
 
-	if (verified_cache->version != version) {
+	if (latest->version != version) {
 		printk(BIOS_DEBUG, "MRC cache version mismatch: %x vs %x\n",
-			verified_cache->version, version);
+			latest->version, version);
 		return -1;
 	}
 
-	printk(BIOS_DEBUG, "MRC cache slot %d @ %p\n", slot-1, verified_cache);
+	printk(BIOS_DEBUG, "MRC cache slot %d @ %p\n", slot, latest);
 
 	return 0;
 }
@@ -166,7 +222,7 @@ int mrc_cache_get_current_with_version(const struct mrc_saved_data **cache,
 	if (mrc_cache_get_region(&region) < 0)
 		return -1;
 
-	return __mrc_cache_get_current(&region, cache, version);
+	return __mrc_cache_get_current(&region, cache, version, NULL);
 }
 
 int mrc_cache_get_current(const struct mrc_saved_data **cache)
@@ -287,6 +343,7 @@ static void update_mrc_cache(void *unused)
 	const struct mrc_saved_data *current_saved;
 	const struct mrc_saved_data *next_slot;
 	struct mrc_data_region region;
+	int corrupt;
 
 	printk(BIOS_DEBUG, "Updating MRC cache data.\n");
 
@@ -308,8 +365,13 @@ static void update_mrc_cache(void *unused)
 
 	current_saved = NULL;
 
+	/*
+	 * A corrupt last slot is rewritten even if the older copy matches, so
+	 * later boots don't have to fall back again.
+	 */
 	if (!__mrc_cache_get_current(&region, &current_saved,
-					current_boot->version)) {
+					current_boot->version, &corrupt) &&
+	    !corrupt) {
 		if (current_saved->size == current_boot->size &&
 		    !memcmp(&current_saved->data[0], &current_boot->data[0],
 		            current_saved->size)) {
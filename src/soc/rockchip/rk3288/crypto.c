@@ -67,6 +67,28 @@ struct rk3288_crypto {
 } *crypto = (void *)CRYPTO_BASE;
 check_member(rk3288_crypto, trng_dout[7], 0x220);
 
+/* Set while the hash DMA started by the last extend call may still run. */
+static int dma_pending;
+
+static int wait_for_dma(void)
+{
+	uint32_t intsts;
+
+	if (!dma_pending)
+		return VB2_SUCCESS;
+
+	dma_pending = 0;
+	do {
+		intsts = read32(&crypto->intsts);
+		if (intsts & HRDMA_ERR) {
+			printk(BIOS_ERR, "ERROR: DMA error during HW crypto\n");
+			return VB2_ERROR_UNKNOWN;
+		}
+	} while (!(intsts & HRDMA_DONE));	/* wait for DMA to finish */
+
+	return VB2_SUCCESS;
+}
+
 int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 			       uint32_t data_size)
 {
@@ -79,6 +101,7 @@ int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 	write32(&crypto->ctrl, RK_SETBITS(1 << 6));	/* Assert HASH_FLUSH */
 	udelay(1);					/* for 10+ cycles to */
 	write32(&crypto->ctrl, RK_CLRBITS(1 << 6));	/* clear out old hash */
+	dma_pending = 0;
 
 	/* Enable DMA byte swapping for little-endian bus (Byteswap_??FIFO) */
 	write32(&crypto->conf, 1 << 5 | 1 << 4 | 1 << 3);
@@ -95,7 +118,10 @@ int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 
 int vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
 {
-	uint32_t intsts;
+	/* Only one block can be in flight. The caller owns buf again once
+	 * the next extend or finalize call has waited for its DMA. */
+	if (wait_for_dma())
+		return VB2_ERROR_UNKNOWN;
 
 	write32(&crypto->intsts, HRDMA_ERR | HRDMA_DONE); /* clear interrupts */
 
@@ -103,13 +129,7 @@ int vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
 	write32(&crypto->hrdmas, (uint32_t)buf);
 	write32(&crypto->hrdmal, size / sizeof(uint32_t));
 	write32(&crypto->ctrl, RK_SETBITS(1 << 3));	/* Set HASH_START */
-	do {
-		intsts = read32(&crypto->intsts);
-		if (intsts & HRDMA_ERR) {
-			printk(BIOS_ERR, "ERROR: DMA error during HW crypto\n");
-			return VB2_ERROR_UNKNOWN;
-		}
-	} while (!(intsts & HRDMA_DONE));	/* wait for DMA to finish */
+	dma_pending = 1;
 
 	return VB2_SUCCESS;
 }
@@ -120,6 +140,9 @@ int vb2ex_hwcrypto_digest_finalize(uint8_t *digest, uint32_t digest_size)
 	uint32_t *src = crypto->hash_dout;
 	assert(digest_size == sizeof(crypto->hash_dout));
 
+	if (wait_for_dma())
+		return VB2_ERROR_UNKNOWN;
+
 	while (!(read32(&crypto->hash_sts) & 0x1))
 		/* wait for crypto engine to set HASH_DONE bit */;
 
@@ -14,6 +14,7 @@
  */
 
 #include <antirollback.h>
+#include <arch/early_variables.h>
 #include <arch/exception.h>
 #include <assert.h>
 #include <bootmode.h>
@@ -29,7 +30,12 @@
 /* The max hash size to expect is for SHA512. */
 #define VBOOT_MAX_HASH_SIZE VB2_SHA512_DIGEST_SIZE
 
-#define TODO_BLOCK_SIZE 1024
+/*
+ * Firmware body blocks used when the boot media isn't memory mapped. The two
+ * blocks are filled alternately so that a hardware crypto engine can still be
+ * digesting one block while the next one is read into the other.
+ */
+static uint8_t hash_blocks[2][CONFIG_VBOOT_HASH_BLOCK_SIZE] CAR_GLOBAL;
 
 static int is_slot_a(struct vb2_context *ctx)
 {
@@ -92,7 +98,15 @@ int vb2ex_read_resource(struct vb2_context *ctx,
 	return VB2_SUCCESS;
 }
 
-/* No-op stubs that can be overridden by SoCs with hardware crypto support. */
+/*
+ * No-op stubs that can be overridden by SoCs with hardware crypto support.
+ *
+ * The body is hashed as a stream: vb2ex_hwcrypto_digest_extend() may return
+ * before it is done with buf, which is only required to stay untouched until
+ * the next call to vb2ex_hwcrypto_digest_extend() or
+ * vb2ex_hwcrypto_digest_finalize(). Implementations which start a DMA
+ * transfer therefore only need to wait for the previous transfer.
+ */
 __attribute__((weak))
 int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
 			       uint32_t data_size)
@@ -170,15 +184,47 @@ static int handle_digest_result(void *slot_hash, size_t slot_hash_sz)
 	return 0;
 }
 
+/* Extend the body hash in blocks read from non memory mapped boot media. */
+static int hash_body_blocks(struct vb2_context *ctx,
+			    const struct region_device *fw_main,
+			    uint64_t *load_ts)
+{
+	uint8_t (*blocks)[CONFIG_VBOOT_HASH_BLOCK_SIZE];
+	size_t remaining = region_device_sz(fw_main);
+	size_t offset = 0;
+	int cur = 0;
+	int rv;
+
+	blocks = car_get_var_ptr(hash_blocks);
+
+	while (remaining) {
+		uint64_t temp_ts;
+		size_t block_size = MIN(remaining, sizeof(blocks[cur]));
+
+		temp_ts = timestamp_get();
+		if (rdev_readat(fw_main, blocks[cur], offset, block_size) < 0)
+			return VB2_ERROR_UNKNOWN;
+		*load_ts += timestamp_get() - temp_ts;
+
+		rv = vb2api_extend_hash(ctx, blocks[cur], block_size);
+		if (rv)
+			return rv;
+
+		remaining -= block_size;
+		offset += block_size;
+		cur ^= 1;
+	}
+
+	return VB2_SUCCESS;
+}
+
 static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 {
 	uint64_t load_ts;
 	uint32_t expected_size;
-	uint8_t block[TODO_BLOCK_SIZE];
 	uint8_t hash_digest[VBOOT_MAX_HASH_SIZE];
 	const size_t hash_digest_sz = sizeof(hash_digest);
-	size_t block_size = sizeof(block);
-	size_t offset;
+	void *mapping = NULL;
 	int rv;
 
 	/* Clear the full digest so that any hash digests less than the
@@ -195,7 +241,6 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 	timestamp_add(TS_START_HASH_BODY, load_ts);
 
 	expected_size = region_device_sz(fw_main);
-	offset = 0;
 
 	/* Start the body hash */
 	rv = vb2api_init_hash(ctx, VB2_HASH_TAG_FW_BODY, &expected_size);
@@ -213,39 +258,41 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 		return VB2_ERROR_UNKNOWN;
 	}
 
-	/* Extend over the body */
-	while (expected_size) {
-		uint64_t temp_ts;
-		if (block_size > expected_size)
-			block_size = expected_size;
-
-		temp_ts = timestamp_get();
-		if (rdev_readat(fw_main, block, offset, block_size) < 0)
+	/*
+	 * Extend over the body. Memory mapped media is hashed in place
+	 * without copying it. The mapping is kept until the digest is
+	 * final since hardware crypto may still be reading from it.
+	 */
+	if (IS_ENABLED(CONFIG_BOOT_DEVICE_MEMORY_MAPPED)) {
+		mapping = rdev_mmap_full(fw_main);
+		if (mapping == NULL)
 			return VB2_ERROR_UNKNOWN;
-		load_ts += timestamp_get() - temp_ts;
-
-		rv = vb2api_extend_hash(ctx, block, block_size);
-		if (rv)
-			return rv;
-
-		expected_size -= block_size;
-		offset += block_size;
+		rv = vb2api_extend_hash(ctx, mapping, expected_size);
+	} else {
+		rv = hash_body_blocks(ctx, fw_main, &load_ts);
 	}
 
+	if (rv)
+		goto out;
+
 	timestamp_add(TS_DONE_LOADING, load_ts);
 	timestamp_add_now(TS_DONE_HASHING);
 
 	/* Check the result (with RSA signature verification) */
 	rv = vb2api_check_hash_get_digest(ctx, hash_digest, hash_digest_sz);
 	if (rv)
-		return rv;
+		goto out;
 
 	timestamp_add_now(TS_END_HASH_BODY);
 
 	if (handle_digest_result(hash_digest, hash_digest_sz))
-		return VB2_ERROR_UNKNOWN;
+		rv = VB2_ERROR_UNKNOWN;
 
-	return VB2_SUCCESS;
+out:
+	if (mapping != NULL)
+		rdev_munmap(fw_main, mapping);
+
+	return rv;
 }
 
 static int locate_firmware(struct vb2_context *ctx,
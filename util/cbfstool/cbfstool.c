@@ -23,6 +23,7 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <pthread.h>
 #include "common.h"
 #include "cbfs.h"
 #include "cbfs_image.h"
@@ -46,7 +47,11 @@ struct command {
 	bool modifies_region;
 };
 
-static struct param {
+/*
+ * Thread local so that batch mode can run the conversion (and compression)
+ * of several entries with their own parameters on worker threads.
+ */
+static __thread struct param {
 	partitioned_file_t *image_file;
 	struct buffer *image_region;
 	const char *name;
@@ -83,6 +88,7 @@ static struct param {
 	char *initrd;
 	char *cmdline;
 	int force;
+	unsigned int jobs;
 } param = {
 	/* All variables not listed are initialized as zero. */
 	.arch = CBFS_ARCHITECTURE_UNKNOWN,
@@ -327,37 +333,37 @@ done:
 	return ret;
 }
 
-static int cbfs_add_component(const char *filename,
-			      const char *name,
-			      uint32_t type,
-			      uint32_t offset,
-			      uint32_t headeroffset,
-			      convert_buffer_t convert)
-{
-	if (!filename) {
-		ERROR("You need to specify -f/--filename.\n");
-		return 1;
-	}
-
-	if (!name) {
-		ERROR("You need to specify -n/--name.\n");
-		return 1;
-	}
+/* A CBFS file that has been converted but not yet added to an image. */
+struct cbfs_component {
+	struct buffer buffer;
+	struct cbfs_file *header;
+	uint32_t offset;
+};
 
-	if (type == 0) {
-		ERROR("You need to specify a valid -t/--type.\n");
-		return 1;
-	}
+struct batch_entry;
 
-	struct cbfs_image image;
-	if (cbfs_image_from_buffer(&image, param.image_region, headeroffset))
-		return 1;
+/*
+ * Set on batch worker threads: cbfs_add_component() then only converts the
+ * file into the entry, it is added to the image later in manifest order.
+ */
+static __thread struct batch_entry *batch_current;
+static struct cbfs_component *batch_entry_component(struct batch_entry *entry);
 
-	if (cbfs_get_entry(&image, name)) {
-		ERROR("'%s' already in ROM image.\n", name);
-		return 1;
-	}
+static void cbfs_component_delete(struct cbfs_component *comp)
+{
+	free(comp->header);
+	comp->header = NULL;
+	buffer_delete(&comp->buffer);
+}
 
+/* Load, convert and hash a file and create its CBFS header. */
+static int cbfs_prepare_component(const char *filename,
+				  const char *name,
+				  uint32_t type,
+				  uint32_t offset,
+				  convert_buffer_t convert,
+				  struct cbfs_component *comp)
+{
 	struct buffer buffer;
 	if (buffer_from_file(&buffer, filename) != 0) {
 		ERROR("Could not load file '%s'.\n", filename);
@@ -417,22 +423,87 @@ static int cbfs_add_component(const char *filename,
 		}
 	}
 
+	comp->buffer = buffer;
+	comp->header = header;
+	comp->offset = offset;
+	return 0;
+}
+
+/* Add a prepared file to the current image region. */
+static int cbfs_place_component(const char *filename,
+				const char *name,
+				uint32_t headeroffset,
+				const struct cbfs_component *comp)
+{
+	uint32_t offset = comp->offset;
+	struct buffer buffer = comp->buffer;
+
+	struct cbfs_image image;
+	if (cbfs_image_from_buffer(&image, param.image_region, headeroffset))
+		return 1;
+
+	if (cbfs_get_entry(&image, name)) {
+		ERROR("'%s' already in ROM image.\n", name);
+		return 1;
+	}
+
 	if (IS_TOP_ALIGNED_ADDRESS(offset))
 		offset = convert_to_from_top_aligned(param.image_region,
 								-offset);
 
-	if (cbfs_add_entry(&image, &buffer, offset, header) != 0) {
+	if (cbfs_add_entry(&image, &buffer, offset, comp->header) != 0) {
 		ERROR("Failed to add '%s' into ROM image.\n", filename);
-		free(header);
-		buffer_delete(&buffer);
 		return 1;
 	}
 
-	free(header);
-	buffer_delete(&buffer);
 	return 0;
 }
 
+static int cbfs_add_component(const char *filename,
+			      const char *name,
+			      uint32_t type,
+			      uint32_t offset,
+			      uint32_t headeroffset,
+			      convert_buffer_t convert)
+{
+	if (!filename) {
+		ERROR("You need to specify -f/--filename.\n");
+		return 1;
+	}
+
+	if (!name) {
+		ERROR("You need to specify -n/--name.\n");
+		return 1;
+	}
+
+	if (type == 0) {
+		ERROR("You need to specify a valid -t/--type.\n");
+		return 1;
+	}
+
+	if (batch_current)
+		return cbfs_prepare_component(filename, name, type, offset,
+				convert, batch_entry_component(batch_current));
+
+	struct cbfs_image image;
+	if (cbfs_image_from_buffer(&image, param.image_region, headeroffset))
+		return 1;
+
+	if (cbfs_get_entry(&image, name)) {
+		ERROR("'%s' already in ROM image.\n", name);
+		return 1;
+	}
+
+	struct cbfs_component comp;
+	if (cbfs_prepare_component(filename, name, type, offset, convert,
+				   &comp))
+		return 1;
+
+	int ret = cbfs_place_component(filename, name, headeroffset, &comp);
+	cbfs_component_delete(&comp);
+	return ret;
+}
+
 static int cbfstool_convert_raw(struct buffer *buffer,
 	unused uint32_t *offset, struct cbfs_file *header)
 {
@@ -1070,6 +1141,323 @@ static int cbfs_compact(void)
 	return cbfs_compact_instance(&image);
 }
 
+/*
+ * Batch mode: add all files listed in a manifest in one invocation. Every
+ * manifest line holds an add, add-flat-binary, add-payload, add-stage,
+ * add-int or remove command with its options, like on the command line.
+ * The files are converted (and compressed) on a pool of threads first and
+ * then added to each selected region in manifest order.
+ */
+struct batch_entry {
+	const struct command *command;
+	struct param param;
+	unsigned int lineno;
+	char *line;
+	char **argv;
+	bool prepared;
+	int ret;
+	struct cbfs_component comp;
+};
+
+static struct batch {
+	const char *manifest;
+	struct batch_entry *entries;
+	size_t count;
+	/* Next entry to be converted, protected by the lock. */
+	size_t next;
+	pthread_mutex_t lock;
+	bool prepared;
+} batch = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static const struct command *find_command(const char *name);
+static int parse_options(int argc, char **argv, const struct command *command);
+
+static struct cbfs_component *batch_entry_component(struct batch_entry *entry)
+{
+	return &entry->comp;
+}
+
+/* Entries that need to look at the image can only be handled in order. */
+static bool batch_entry_is_parallel(const struct batch_entry *entry)
+{
+	int (*function)(void) = entry->command->function;
+	const struct param *p = &entry->param;
+
+	if (function == cbfs_add)
+		return !p->alignment && p->type != CBFS_COMPONENT_FSP;
+	if (function == cbfs_add_stage)
+		return !p->stage_xip;
+	return function == cbfs_add_payload || function == cbfs_add_flat_binary;
+}
+
+static bool batch_command_allowed(const struct command *command)
+{
+	int (*function)(void) = command->function;
+
+	return function == cbfs_add || function == cbfs_add_flat_binary ||
+		function == cbfs_add_payload || function == cbfs_add_stage ||
+		function == cbfs_add_integer || function == cbfs_remove;
+}
+
+/* Split a manifest line into words. Double quotes group words. */
+static int batch_split_line(char *line, char ***argv_out)
+{
+	size_t max = strlen(line) / 2 + 2;
+	char **argv = calloc(max, sizeof(*argv));
+	int argc = 0;
+	char *src = line;
+	char *dst = line;
+
+	if (!argv)
+		return -1;
+
+	while (*src) {
+		bool quoted = false;
+
+		while (isspace((unsigned char)*src))
+			src++;
+		if (!*src)
+			break;
+
+		argv[argc++] = dst;
+		while (*src && (quoted || !isspace((unsigned char)*src))) {
+			if (*src == '"')
+				quoted = !quoted;
+			else
+				*dst++ = *src;
+			src++;
+		}
+		if (*src)
+			src++;
+		*dst++ = '\0';
+	}
+
+	*argv_out = argv;
+	return argc;
+}
+
+static int batch_parse_manifest(const char *manifest)
+{
+	struct param defaults = param;
+	FILE *f;
+	char *line = NULL;
+	size_t len = 0;
+	unsigned int lineno = 0;
+	int ret = 1;
+
+	f = fopen(manifest, "r");
+	if (!f) {
+		ERROR("Could not open manifest '%s'.\n", manifest);
+		return 1;
+	}
+
+	/* Options given to the batch command are defaults for all entries. */
+	defaults.filename = NULL;
+	defaults.name = NULL;
+
+	while (getline(&line, &len, f) != -1) {
+		struct batch_entry *entry;
+		char **argv;
+		char *copy;
+		int argc;
+
+		lineno++;
+
+		copy = strdup(line);
+		if (!copy)
+			goto out;
+		argc = batch_split_line(copy, &argv);
+		if (argc < 0) {
+			free(copy);
+			goto out;
+		}
+		if (argc == 0 || argv[0][0] == '#') {
+			free(argv);
+			free(copy);
+			continue;
+		}
+
+		entry = realloc(batch.entries,
+				(batch.count + 1) * sizeof(*entry));
+		if (!entry) {
+			free(argv);
+			free(copy);
+			goto out;
+		}
+		batch.entries = entry;
+		entry = &batch.entries[batch.count++];
+		memset(entry, 0, sizeof(*entry));
+		entry->lineno = lineno;
+		entry->line = copy;
+		entry->argv = argv;
+
+		entry->command = find_command(argv[0]);
+		if (!entry->command || !batch_command_allowed(entry->command)) {
+			ERROR("%s:%u: Command '%s' can't be used in a batch.\n",
+			      manifest, lineno, argv[0]);
+			goto out;
+		}
+
+		param = defaults;
+		param.region_name = NULL;
+		/* Restart option parsing (GNU getopt). */
+		optind = 0;
+		if (parse_options(argc, argv, entry->command)) {
+			ERROR("%s:%u: Invalid options.\n", manifest, lineno);
+			goto out;
+		}
+		if (param.region_name) {
+			ERROR("%s:%u: Regions can only be selected for the whole batch.\n",
+			      manifest, lineno);
+			goto out;
+		}
+		entry->param = param;
+	}
+
+	ret = 0;
+out:
+	param = defaults;
+	free(line);
+	fclose(f);
+	return ret;
+}
+
+static void *batch_worker(unused void *arg)
+{
+	for (;;) {
+		struct batch_entry *entry;
+		size_t i;
+
+		pthread_mutex_lock(&batch.lock);
+		i = batch.next++;
+		pthread_mutex_unlock(&batch.lock);
+
+		if (i >= batch.count)
+			break;
+
+		entry = &batch.entries[i];
+		if (!batch_entry_is_parallel(entry))
+			continue;
+
+		param = entry->param;
+		batch_current = entry;
+		entry->ret = entry->command->function();
+		batch_current = NULL;
+		entry->prepared = entry->ret == 0;
+	}
+
+	return NULL;
+}
+
+/* Convert all entries that don't depend on the image on a thread pool. */
+static int batch_prepare(void)
+{
+	struct param saved = param;
+	long jobs = param.jobs;
+	pthread_t *threads;
+	long started = 0;
+	size_t i;
+
+	if (jobs == 0)
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (jobs < 1)
+		jobs = 1;
+	if ((size_t)jobs > batch.count)
+		jobs = batch.count ? batch.count : 1;
+
+	/* The calling thread is one of the workers. */
+	threads = calloc(jobs, sizeof(*threads));
+	if (!threads)
+		return 1;
+	while (started < jobs - 1) {
+		if (pthread_create(&threads[started], NULL, batch_worker, NULL))
+			break;
+		started++;
+	}
+	DEBUG("batch: converting %zu entries on %ld threads\n", batch.count,
+	      started + 1);
+
+	batch_worker(NULL);
+	while (started > 0)
+		pthread_join(threads[--started], NULL);
+	free(threads);
+	param = saved;
+
+	for (i = 0; i < batch.count; i++) {
+		struct batch_entry *entry = &batch.entries[i];
+
+		if (batch_entry_is_parallel(entry) && entry->ret) {
+			ERROR("%s:%u: Failed to convert '%s'.\n",
+			      batch.manifest, entry->lineno,
+			      entry->param.filename ? entry->param.filename :
+			      "(none)");
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void batch_cleanup(void)
+{
+	size_t i;
+
+	for (i = 0; i < batch.count; i++) {
+		cbfs_component_delete(&batch.entries[i].comp);
+		free(batch.entries[i].argv);
+		free(batch.entries[i].line);
+	}
+	free(batch.entries);
+	batch.entries = NULL;
+	batch.count = 0;
+}
+
+static int cbfs_batch(void)
+{
+	struct param saved = param;
+	size_t i;
+	int ret = 0;
+
+	if (!param.filename) {
+		ERROR("You need to specify -f/--file.\n");
+		return 1;
+	}
+
+	/* With several regions, the entries are only converted once. */
+	if (!batch.prepared) {
+		atexit(batch_cleanup);
+		batch.manifest = param.filename;
+		if (batch_parse_manifest(param.filename) || batch_prepare())
+			return 1;
+		batch.prepared = true;
+	}
+
+	for (i = 0; i < batch.count && !ret; i++) {
+		struct batch_entry *entry = &batch.entries[i];
+
+		param = entry->param;
+		param.image_file = saved.image_file;
+		param.image_region = saved.image_region;
+		param.region_name = saved.region_name;
+
+		if (entry->prepared)
+			ret = cbfs_place_component(param.filename, param.name,
+						   param.headeroffset,
+						   &entry->comp);
+		else
+			ret = entry->command->function();
+
+		if (ret)
+			ERROR("%s:%u: Failed to process entry.\n",
+			      batch.manifest, entry->lineno);
+	}
+
+	param = saved;
+	return ret;
+}
+
 static const struct command commands[] = {
 	{"add", "H:r:f:n:t:c:b:a:yvA:gh?", cbfs_add, true, true},
 	{"add-flat-binary", "H:r:f:n:l:e:c:b:vA:gh?", cbfs_add_flat_binary,
@@ -1080,6 +1468,7 @@ static const struct command commands[] = {
 				true, true},
 	{"add-int", "H:r:i:n:b:vgh?", cbfs_add_integer, true, true},
 	{"add-master-header", "H:r:vh?", cbfs_add_master_header, true, true},
+	{"batch", "H:r:f:j:vh?", cbfs_batch, true, true},
 	{"compact", "r:h?", cbfs_compact, true, true},
 	{"copy", "r:R:h?", cbfs_copy, true, true},
 	{"create", "M:r:s:B:b:H:o:m:vh?", cbfs_create, true, true},
@@ -1113,6 +1502,7 @@ static struct option long_options[] = {
 	{"ignore-sec",    required_argument, 0, 'S' },
 	{"initrd",        required_argument, 0, 'I' },
 	{"int",           required_argument, 0, 'i' },
+	{"jobs",          required_argument, 0, 'j' },
 	{"load-address",  required_argument, 0, 'l' },
 	{"machine",       required_argument, 0, 'm' },
 	{"name",          required_argument, 0, 'n' },
@@ -1215,6 +1605,8 @@ static void usage(char *name)
 			"Add a raw 64-bit integer value\n"
 	     " add-master-header [-r image,regions]                        "
 			"Add a legacy CBFS master header\n"
+	     " batch [-r image,regions] -f MANIFEST [-j jobs]              "
+			"Add the files listed in MANIFEST\n"
 	     " remove [-r image,regions] -n NAME                           "
 			"Remove a component\n"
 	     " compact -r image,regions                                    "
@@ -1248,6 +1640,16 @@ static void usage(char *name)
 	     "  in two possible formats: if their value is greater than\n"
 	     "  0x80000000, they are interpreted as a top-aligned x86 memory\n"
 	     "  address; otherwise, they are treated as an offset into flash.\n"
+	     "MANIFESTs:\n"
+	     "  Each line of a batch manifest holds one add, add-flat-binary,\n"
+	     "  add-payload, add-stage, add-int or remove command with its\n"
+	     "  options, e.g. 'add-stage -f romstage.elf -n fallback/romstage'.\n"
+	     "  Files are converted in parallel using -j threads (default:\n"
+	     "  number of CPUs) and then added in manifest order.\n"
+	     "ENVIRONMENT:\n"
+	     "  CBFSTOOL_COMPRESSION_CACHE names a directory in which LZMA and\n"
+	     "  LZ4 compression results are cached, keyed by a hash of the\n"
+	     "  input, to speed up rebuilds.\n"
 	     "ARCHes:\n"
 	     "  arm64, arm, mips, x86\n"
 	     "TYPEs:\n", name, name
@@ -1275,239 +1677,267 @@ static void usage(char *name)
 	     );
 }
 
-int main(int argc, char **argv)
+static const struct command *find_command(const char *name)
 {
 	size_t i;
-	int c;
 
-	if (argc < 3) {
-		usage(argv[0]);
-		return 1;
+	for (i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(name, commands[i].name) == 0)
+			return &commands[i];
 	}
+	return NULL;
+}
 
-	char *image_name = argv[1];
-	char *cmd = argv[2];
-	optind += 2;
-
-	for (i = 0; i < ARRAY_SIZE(commands); i++) {
-		if (strcmp(cmd, commands[i].name) != 0)
-			continue;
+static int parse_options(int argc, char **argv, const struct command *command)
+{
+	int c;
 
-		while (1) {
-			char *suffix = NULL;
-			int option_index = 0;
+	while (1) {
+		char *suffix = NULL;
+		int option_index = 0;
 
-			c = getopt_long(argc, argv, commands[i].optstring,
-						long_options, &option_index);
-			if (c == -1) {
-				if (optind < argc) {
-					ERROR("%s: excessive argument -- '%s'"
-						"\n", argv[0], argv[optind]);
-					return 1;
-				}
-				break;
+		c = getopt_long(argc, argv, command->optstring,
+					long_options, &option_index);
+		if (c == -1) {
+			if (optind < argc) {
+				ERROR("%s: excessive argument -- '%s'"
+					"\n", argv[0], argv[optind]);
+				return 1;
 			}
+			break;
+		}
 
-			/* filter out illegal long options */
-			if (strchr(commands[i].optstring, c) == NULL) {
-				/* TODO maybe print actual long option instead */
-				ERROR("%s: invalid option -- '%c'\n",
-				      argv[0], c);
-				c = '?';
-			}
+		/* filter out illegal long options */
+		if (strchr(command->optstring, c) == NULL) {
+			/* TODO maybe print actual long option instead */
+			ERROR("%s: invalid option -- '%c'\n",
+			      argv[0], c);
+			c = '?';
+		}
 
-			switch(c) {
-			case 'n':
-				param.name = optarg;
-				break;
-			case 't':
-				if (intfiletype(optarg) != ((uint64_t) - 1))
-					param.type = intfiletype(optarg);
-				else
-					param.type = strtoul(optarg, NULL, 0);
-				if (param.type == 0)
-					WARN("Unknown type '%s' ignored\n",
-							optarg);
-				break;
-			case 'c': {
-				int algo = cbfs_parse_comp_algo(optarg);
-				if (algo >= 0)
-					param.compression = algo;
-				else
-					WARN("Unknown compression '%s' ignored.\n",
-									optarg);
-				break;
-			}
-			case 'A': {
-				int algo = cbfs_parse_hash_algo(optarg);
-				if (algo >= 0)
-					param.hash = algo;
-				else {
-					ERROR("Unknown hash algorithm '%s'.\n",
+		switch(c) {
+		case 'n':
+			param.name = optarg;
+			break;
+		case 't':
+			if (intfiletype(optarg) != ((uint64_t) - 1))
+				param.type = intfiletype(optarg);
+			else
+				param.type = strtoul(optarg, NULL, 0);
+			if (param.type == 0)
+				WARN("Unknown type '%s' ignored\n",
 						optarg);
-					return 1;
-				}
-				break;
+			break;
+		case 'c': {
+			int algo = cbfs_parse_comp_algo(optarg);
+			if (algo >= 0)
+				param.compression = algo;
+			else
+				WARN("Unknown compression '%s' ignored.\n",
+								optarg);
+			break;
+		}
+		case 'A': {
+			int algo = cbfs_parse_hash_algo(optarg);
+			if (algo >= 0)
+				param.hash = algo;
+			else {
+				ERROR("Unknown hash algorithm '%s'.\n",
+					optarg);
+				return 1;
 			}
-			case 'M':
-				param.fmap = optarg;
-				break;
-			case 'r':
-				param.region_name = optarg;
-				break;
-			case 'R':
-				param.source_region = optarg;
-				break;
-			case 'b':
-				param.baseaddress = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid base address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				// baseaddress may be zero on non-x86, so we
-				// need an explicit "baseaddress_assigned".
-				param.baseaddress_assigned = 1;
-				break;
-			case 'l':
-				param.loadaddress = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid load address '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'e':
-				param.entrypoint = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid entry point '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 's':
-				param.size = strtoul(optarg, &suffix, 0);
-				if (!*optarg) {
-					ERROR("Empty size specified.\n");
-					return 1;
-				}
-				switch (tolower((int)suffix[0])) {
-				case 'k':
-					param.size *= 1024;
-					break;
-				case 'm':
-					param.size *= 1024 * 1024;
-					break;
-				case '\0':
-					break;
-				default:
-					ERROR("Invalid suffix for size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'B':
-				param.bootblock = optarg;
-				break;
-			case 'H':
-				param.headeroffset = strtoul(
-						optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid header offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.headeroffset_assigned = 1;
-				break;
-			case 'a':
-				param.alignment = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid alignment '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'P':
-				param.pagesize = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid page size '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'o':
-				param.cbfsoffset = strtoul(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid cbfs offset '%s'.\n",
-						optarg);
-					return 1;
-				}
-				param.cbfsoffset_assigned = 1;
-				break;
-			case 'f':
-				param.filename = optarg;
-				break;
-			case 'F':
-				param.force = 1;
-				break;
-			case 'i':
-				param.u64val = strtoull(optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid int parameter '%s'.\n",
-						optarg);
-					return 1;
-				}
-				break;
-			case 'u':
-				param.fill_partial_upward = true;
-				break;
-			case 'd':
-				param.fill_partial_downward = true;
-				break;
-			case 'w':
-				param.show_immutable = true;
-				break;
-			case 'x':
-				param.fit_empty_entries = strtol(
-						optarg, &suffix, 0);
-				if (!*optarg || (suffix && *suffix)) {
-					ERROR("Invalid number of fit entries "
-						"'%s'.\n", optarg);
-					return 1;
-				}
-				break;
-			case 'v':
-				verbose++;
+			break;
+		}
+		case 'M':
+			param.fmap = optarg;
+			break;
+		case 'r':
+			param.region_name = optarg;
+			break;
+		case 'R':
+			param.source_region = optarg;
+			break;
+		case 'b':
+			param.baseaddress = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid base address '%s'.\n",
+					optarg);
+				return 1;
+			}
+			// baseaddress may be zero on non-x86, so we
+			// need an explicit "baseaddress_assigned".
+			param.baseaddress_assigned = 1;
+			break;
+		case 'l':
+			param.loadaddress = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid load address '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'e':
+			param.entrypoint = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid entry point '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 's':
+			param.size = strtoul(optarg, &suffix, 0);
+			if (!*optarg) {
+				ERROR("Empty size specified.\n");
+				return 1;
+			}
+			switch (tolower((int)suffix[0])) {
+			case 'k':
+				param.size *= 1024;
 				break;
 			case 'm':
-				param.arch = string_to_arch(optarg);
-				break;
-			case 'I':
-				param.initrd = optarg;
+				param.size *= 1024 * 1024;
 				break;
-			case 'C':
-				param.cmdline = optarg;
-				break;
-			case 'S':
-				param.ignore_section = optarg;
-				break;
-			case 'y':
-				param.stage_xip = true;
-				break;
-			case 'g':
-				param.autogen_attr = true;
-				break;
-			case 'k':
-				param.machine_parseable = true;
+			case '\0':
 				break;
-			case 'h':
-			case '?':
-				usage(argv[0]);
-				return 1;
 			default:
-				break;
+				ERROR("Invalid suffix for size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'B':
+			param.bootblock = optarg;
+			break;
+		case 'H':
+			param.headeroffset = strtoul(
+					optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid header offset '%s'.\n",
+					optarg);
+				return 1;
+			}
+			param.headeroffset_assigned = 1;
+			break;
+		case 'a':
+			param.alignment = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid alignment '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'P':
+			param.pagesize = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid page size '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'o':
+			param.cbfsoffset = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid cbfs offset '%s'.\n",
+					optarg);
+				return 1;
 			}
+			param.cbfsoffset_assigned = 1;
+			break;
+		case 'f':
+			param.filename = optarg;
+			break;
+		case 'F':
+			param.force = 1;
+			break;
+		case 'i':
+			param.u64val = strtoull(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid int parameter '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'u':
+			param.fill_partial_upward = true;
+			break;
+		case 'd':
+			param.fill_partial_downward = true;
+			break;
+		case 'w':
+			param.show_immutable = true;
+			break;
+		case 'x':
+			param.fit_empty_entries = strtol(
+					optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid number of fit entries "
+					"'%s'.\n", optarg);
+				return 1;
+			}
+			break;
+		case 'j':
+			param.jobs = strtoul(optarg, &suffix, 0);
+			if (!*optarg || (suffix && *suffix)) {
+				ERROR("Invalid number of jobs '%s'.\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'v':
+			verbose++;
+			break;
+		case 'm':
+			param.arch = string_to_arch(optarg);
+			break;
+		case 'I':
+			param.initrd = optarg;
+			break;
+		case 'C':
+			param.cmdline = optarg;
+			break;
+		case 'S':
+			param.ignore_section = optarg;
+			break;
+		case 'y':
+			param.stage_xip = true;
+			break;
+		case 'g':
+			param.autogen_attr = true;
+			break;
+		case 'k':
+			param.machine_parseable = true;
+			break;
+		case 'h':
+		case '?':
+			usage(argv[0]);
+			return 1;
+		default:
+			break;
 		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t i;
+
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	char *image_name = argv[1];
+	char *cmd = argv[2];
+	optind += 2;
+
+	for (i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(cmd, commands[i].name) != 0)
+			continue;
+
+		if (parse_options(argc, argv, &commands[i]))
+			return 1;
 
 		if (commands[i].function == cbfs_create) {
 			if (param.fmap) {
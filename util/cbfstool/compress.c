@@ -21,11 +21,164 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "common.h"
+#include "cbfs.h"
 #include "lz4/lib/lz4frame.h"
 #include <commonlib/compression.h>
 
-static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+/*
+ * Compression results can be cached on disk. If CBFSTOOL_COMPRESSION_CACHE
+ * names a directory, every successful result is stored there in a file named
+ * after the SHA-256 of the algorithm tag and the input, and later
+ * compressions of the same input are read back from it. Failures are not
+ * cached, they may be caused by a transient condition like running out of
+ * memory. The tag has to change whenever the parameters of a compressor
+ * change.
+ */
+#define COMPRESSION_CACHE_ENV	"CBFSTOOL_COMPRESSION_CACHE"
+#define COMPRESSION_CACHE_MAGIC	"CBFSCMP2"
+#define LZ4_CACHE_TAG		"lz4:level20:4MB:independent"
+#define LZMA_CACHE_TAG		"lzma:lc1:lp0:pb0:fb273:bt4"
+
+struct compression_cache_header {
+	char magic[8];
+	uint32_t size;
+};
+
+static char *compression_cache_path(const char *tag, const char *in,
+				    int in_len)
+{
+	const char *dir = getenv(COMPRESSION_CACHE_ENV);
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	struct vb2_digest_context ctx;
+	char *path;
+	size_t len;
+	size_t i;
+
+	if (!dir || !*dir)
+		return NULL;
+
+	/* The terminating NUL separates the tag from the data. */
+	if (vb2_digest_init(&ctx, VB2_HASH_SHA256) != VB2_SUCCESS ||
+	    vb2_digest_extend(&ctx, (const uint8_t *)tag,
+			      strlen(tag) + 1) != VB2_SUCCESS ||
+	    vb2_digest_extend(&ctx, (const uint8_t *)in,
+			      in_len) != VB2_SUCCESS ||
+	    vb2_digest_finalize(&ctx, digest, sizeof(digest)) != VB2_SUCCESS)
+		return NULL;
+
+	len = strlen(dir) + 1 + 2 * sizeof(digest) + 1;
+	path = malloc(len);
+	if (!path)
+		return NULL;
+
+	snprintf(path, len, "%s/", dir);
+	for (i = 0; i < sizeof(digest); i++)
+		sprintf(path + strlen(dir) + 1 + 2 * i, "%02x", digest[i]);
+
+	return path;
+}
+
+/* Returns 1 on a cache hit, with the compressed data in out. */
+static int compression_cache_load(const char *path, char *out, int out_max,
+				  int *out_len)
+{
+	struct compression_cache_header hdr;
+	FILE *f = fopen(path, "rb");
+	int hit = 0;
+
+	if (!f)
+		return 0;
+
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+	    memcmp(hdr.magic, COMPRESSION_CACHE_MAGIC, sizeof(hdr.magic)))
+		goto out;
+
+	if (hdr.size > (uint32_t)out_max ||
+	    fread(out, 1, hdr.size, f) != hdr.size)
+		goto out;
+
+	*out_len = hdr.size;
+	hit = 1;
+out:
+	fclose(f);
+	return hit;
+}
+
+/* Write to a temporary file first so concurrent builds never see a partial
+ * entry. Failures are not fatal, the result just isn't cached. */
+static void compression_cache_store(const char *path, const char *out,
+				    int out_len)
+{
+	struct compression_cache_header hdr;
+	size_t len = strlen(path) + sizeof(".XXXXXX");
+	char *tmp = malloc(len);
+	FILE *f;
+	int fd;
+
+	if (!tmp)
+		return;
+
+	snprintf(tmp, len, "%s.XXXXXX", path);
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		DEBUG("Can't create compression cache file '%s'.\n", tmp);
+		free(tmp);
+		return;
+	}
+
+	f = fdopen(fd, "wb");
+	if (!f) {
+		close(fd);
+		unlink(tmp);
+		free(tmp);
+		return;
+	}
+
+	memcpy(hdr.magic, COMPRESSION_CACHE_MAGIC, sizeof(hdr.magic));
+	hdr.size = out_len;
+
+	if (fwrite(&hdr, sizeof(hdr), 1, f) != 1 ||
+	    fwrite(out, 1, hdr.size, f) != hdr.size) {
+		fclose(f);
+		unlink(tmp);
+	} else if (fclose(f) || rename(tmp, path)) {
+		unlink(tmp);
+	}
+
+	free(tmp);
+}
+
+static int cached_compress(const char *tag, comp_func_ptr compress,
+			   char *in, int in_len, char *out, int *out_len)
+{
+	char *path = compression_cache_path(tag, in, in_len);
+	int len;
+	int ret;
+
+	if (!path)
+		return compress(in, in_len, out, out_len);
+
+	/* All compressors limit their output to in_len bytes. */
+	if (compression_cache_load(path, out, in_len, out_len)) {
+		DEBUG("Compression cache hit for %s\n", path);
+		free(path);
+		return 0;
+	}
+
+	ret = compress(in, in_len, out, &len);
+	if (ret == 0) {
+		*out_len = len;
+		compression_cache_store(path, out, len);
+	}
+	free(path);
+
+	return ret;
+}
+
+static int lz4_compress_uncached(char *in, int in_len, char *out,
+				 int *out_len)
 {
 	LZ4F_preferences_t prefs = {
 		.compressionLevel = 20,
@@ -46,6 +199,12 @@ static int lz4_compress(char *in, int in_len, char *out, int *out_len)
 	return 0;
 }
 
+static int lz4_compress(char *in, int in_len, char *out, int *out_len)
+{
+	return cached_compress(LZ4_CACHE_TAG, lz4_compress_uncached, in,
+			       in_len, out, out_len);
+}
+
 static int lz4_decompress(char *in, int in_len, char *out, int out_len,
 			  size_t *actual_size)
 {
@@ -59,7 +218,8 @@ static int lz4_decompress(char *in, int in_len, char *out, int out_len,
 
 static int lzma_compress(char *in, int in_len, char *out, int *out_len)
 {
-	return do_lzma_compress(in, in_len, out, out_len);
+	return cached_compress(LZMA_CACHE_TAG, do_lzma_compress, in, in_len,
+			       out, out_len);
 }
 
 static int lzma_decompress(char *in, int in_len, char *out, unused int out_len,
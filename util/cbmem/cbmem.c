@@ -33,6 +33,8 @@
 #include <assert.h>
 #include <commonlib/cbmem_id.h>
 #include <commonlib/timestamp_serialized.h>
+#include <commonlib/span_serialized.h>
+#include <commonlib/binlog_serialized.h>
 #include <commonlib/coreboot_tables.h>
 
 #ifdef __OpenBSD__
@@ -571,6 +573,377 @@ static void dump_timestamps(int mach_readable)
 	unmap_memory();
 }
 
+/* Print a span name as JSON string contents. */
+static void print_json_name(const char *name, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len && name[i] != '\0'; i++) {
+		unsigned char c = name[i];
+
+		if (c == '"' || c == '\\')
+			printf("\\%c", c);
+		else if (c < 0x20 || c >= 0x7f)
+			printf("\\u%04x", c);
+		else
+			putchar(c);
+	}
+}
+
+/* dump the boot spans in the Chrome trace event format */
+static void dump_spans(void)
+{
+	struct span_buffer *buf;
+	uint64_t addr;
+	size_t size;
+	uint32_t first, i;
+	unsigned long freq;
+
+	if (find_cbmem_entry(CBMEM_ID_SPANS, &addr, &size)) {
+		fprintf(stderr, "No boot spans found in cbmem.\n");
+		return;
+	}
+
+	if (size < sizeof(*buf)) {
+		fprintf(stderr, "Boot span buffer too small.\n");
+		return;
+	}
+
+	buf = map_memory_size(addr, size, 1);
+
+	if (sizeof(*buf) + (uint64_t)buf->max_events *
+	    sizeof(buf->events[0]) > size || buf->max_events == 0) {
+		fprintf(stderr, "Boot span buffer is corrupted.\n");
+		unmap_memory();
+		return;
+	}
+
+	freq = buf->tick_freq_mhz;
+	if (!freq)
+		freq = arch_tick_frequency();
+	if (!freq) {
+		fprintf(stderr, "Cannot determine timestamp tick frequency.\n");
+		exit(1);
+	}
+
+	/* Only the newest max_events events survive the ring. */
+	first = 0;
+	if (buf->num_events > buf->max_events)
+		first = buf->num_events - buf->max_events;
+
+	printf("{\"traceEvents\":[");
+	for (i = first; i < buf->num_events; i++) {
+		const struct span_event *e =
+			&buf->events[i % buf->max_events];
+
+		printf("%s\n{\"name\":\"", i == first ? "" : ",");
+		print_json_name(e->name, sizeof(e->name));
+		printf("\",\"cat\":\"coreboot\",\"ph\":\"%c\","
+		       "\"ts\":%.3f,\"pid\":0,\"tid\":0}",
+		       e->type == SPAN_BEGIN ? 'B' : 'E',
+		       (double)e->stamp / freq);
+	}
+	printf("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	if (first)
+		fprintf(stderr, "%u oldest span events lost\n", first);
+
+	unmap_memory();
+}
+
+struct binlog_reader {
+	const uint8_t *pos;
+	const uint8_t *end;
+	int error;
+};
+
+static uint64_t binlog_get_unsigned(struct binlog_reader *r)
+{
+	uint64_t val = 0;
+	int shift = 0;
+
+	while (r->pos < r->end && shift < 64) {
+		uint8_t byte = *r->pos++;
+
+		val |= (uint64_t)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return val;
+		shift += 7;
+	}
+	r->error = 1;
+	return 0;
+}
+
+static int64_t binlog_get_signed(struct binlog_reader *r)
+{
+	uint64_t val = binlog_get_unsigned(r);
+
+	return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+static const char *binlog_get_string(struct binlog_reader *r)
+{
+	const char *s = (const char *)r->pos;
+	const uint8_t *nul = memchr(r->pos, '\0', r->end - r->pos);
+
+	if (!nul) {
+		r->error = 1;
+		return "";
+	}
+	r->pos = nul + 1;
+	return s;
+}
+
+/* Build a host printf() conversion for one coreboot conversion. */
+static void binlog_spec(char *spec, size_t len, const char *flags, int width,
+			int precision, const char *conv)
+{
+	int n;
+
+	n = snprintf(spec, len, "%%%s", flags);
+	if (width >= 0)
+		n += snprintf(spec + n, len - n, "%d", width);
+	if (precision >= 0)
+		n += snprintf(spec + n, len - n, ".%d", precision);
+	snprintf(spec + n, len - n, "%s", conv);
+}
+
+/*
+ * Print one record. This walks the format string exactly like vtxprintf()
+ * and the encoder in src/lib/cbmem_binlog.c do.
+ */
+static void print_binlog_record(const char *fmt, struct binlog_reader *r,
+				int pointer_size)
+{
+	char spec[32], flags[8];
+	const char *s;
+	int nflags, width, precision, qualifier, sign;
+	uint64_t num;
+
+	for (; *fmt && !r->error; fmt++) {
+		if (*fmt != '%') {
+			putchar(*fmt);
+			continue;
+		}
+		fmt++;
+
+		nflags = 0;
+		while (*fmt == '-' || *fmt == '+' || *fmt == ' ' ||
+		       *fmt == '#' || *fmt == '0') {
+			if (nflags < sizeof(flags) - 2)
+				flags[nflags++] = *fmt;
+			fmt++;
+		}
+
+		width = -1;
+		if (*fmt == '*') {
+			fmt++;
+			width = binlog_get_signed(r);
+			if (width < 0) {
+				width = -width;
+				flags[nflags++] = '-';
+			}
+		} else if (isdigit(*fmt)) {
+			width = strtol(fmt, (char **)&fmt, 10);
+		}
+		flags[nflags] = '\0';
+
+		precision = -1;
+		if (*fmt == '.') {
+			fmt++;
+			precision = 0;
+			if (*fmt == '*') {
+				fmt++;
+				precision = binlog_get_signed(r);
+			} else if (isdigit(*fmt)) {
+				precision = strtol(fmt, (char **)&fmt, 10);
+			}
+			if (precision < 0)
+				precision = 0;
+		}
+
+		qualifier = -1;
+		if (*fmt == 'h' || *fmt == 'l' || *fmt == 'L' || *fmt == 'z') {
+			qualifier = *fmt;
+			++fmt;
+			if (*fmt == 'l') {
+				qualifier = 'L';
+				++fmt;
+			}
+			if (*fmt == 'h') {
+				qualifier = 'H';
+				++fmt;
+			}
+		}
+		(void)qualifier;
+
+		sign = 0;
+		switch (*fmt) {
+		case 'c':
+			binlog_spec(spec, sizeof(spec),
+				    strchr(flags, '-') ? "-" : "", width, -1,
+				    "c");
+			printf(spec, (int)binlog_get_unsigned(r));
+			continue;
+
+		case 's':
+			/* The encoder already cut the string to precision. */
+			s = binlog_get_string(r);
+			binlog_spec(spec, sizeof(spec),
+				    strchr(flags, '-') ? "-" : "", width, -1,
+				    "s");
+			printf(spec, s);
+			continue;
+
+		case 'p':
+			if (width == -1) {
+				width = 2 * pointer_size;
+				flags[nflags++] = '0';
+				flags[nflags] = '\0';
+			}
+			binlog_spec(spec, sizeof(spec), flags, width, precision,
+				    PRIx64);
+			printf(spec, binlog_get_unsigned(r));
+			continue;
+
+		case 'n':
+			continue;
+
+		case '%':
+			putchar('%');
+			continue;
+
+		case 'd':
+		case 'i':
+			sign = 1;
+			break;
+
+		case 'o':
+		case 'u':
+		case 'x':
+		case 'X':
+			break;
+
+		case '\0':
+			putchar('%');
+			fmt--;
+			continue;
+
+		default:
+			putchar('%');
+			putchar(*fmt);
+			continue;
+		}
+
+		if (sign) {
+			binlog_spec(spec, sizeof(spec), flags, width, precision,
+				    PRId64);
+			printf(spec, binlog_get_signed(r));
+		} else {
+			num = binlog_get_unsigned(r);
+			binlog_spec(spec, sizeof(spec), flags, width, precision,
+				    *fmt == 'o' ? PRIo64 : *fmt == 'u' ? PRIu64 :
+				    *fmt == 'x' ? PRIx64 : PRIX64);
+			printf(spec, num);
+		}
+	}
+}
+
+/* dump the binary log, formatted with the string table of the build */
+static void dump_binlog(const char *strtab_path)
+{
+	struct binlog_buffer *buf;
+	struct binlog_reader r;
+	struct stat st;
+	uint64_t addr;
+	size_t size;
+	uint32_t pos;
+	char *strtab;
+	int fd;
+
+	fd = open(strtab_path, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st)) {
+		fprintf(stderr, "Cannot open %s: %s\n", strtab_path,
+			strerror(errno));
+		exit(1);
+	}
+	strtab = malloc(st.st_size + 1);
+	if (!strtab || read(fd, strtab, st.st_size) != st.st_size) {
+		fprintf(stderr, "Cannot read %s.\n", strtab_path);
+		exit(1);
+	}
+	/* Keep a bad format offset from running off the end. */
+	strtab[st.st_size] = '\0';
+	close(fd);
+
+	if (find_cbmem_entry(CBMEM_ID_BINLOG, &addr, &size)) {
+		fprintf(stderr, "No binary log found in cbmem.\n");
+		free(strtab);
+		return;
+	}
+
+	if (size < sizeof(*buf)) {
+		fprintf(stderr, "Binary log buffer too small.\n");
+		free(strtab);
+		return;
+	}
+
+	buf = map_memory_size(addr, size, 1);
+
+	if (sizeof(*buf) + (uint64_t)buf->size > size ||
+	    buf->cursor > buf->size) {
+		fprintf(stderr, "Binary log buffer is corrupted.\n");
+		goto out;
+	}
+
+	if (buf->format_check + sizeof(BINLOG_CHECK_STRING) > st.st_size ||
+	    strcmp(strtab + buf->format_check, BINLOG_CHECK_STRING)) {
+		fprintf(stderr, "%s doesn't belong to the running firmware.\n",
+			strtab_path);
+		goto out;
+	}
+
+	for (pos = 0; pos + sizeof(struct binlog_record) <= buf->cursor;) {
+		const struct binlog_record *rec =
+			(const void *)&buf->body[pos];
+
+		pos += sizeof(*rec) + rec->length;
+		if (pos > buf->cursor) {
+			fprintf(stderr, "\nTruncated binary log record.\n");
+			break;
+		}
+
+		if (rec->format == BINLOG_FORMAT_TEXT) {
+			fwrite(rec->args, 1, rec->length, stdout);
+			continue;
+		}
+
+		if (rec->format >= st.st_size) {
+			fprintf(stderr, "\nBad format offset 0x%x.\n",
+				rec->format);
+			break;
+		}
+
+		r.pos = rec->args;
+		r.end = rec->args + rec->length;
+		r.error = 0;
+		print_binlog_record(strtab + rec->format, &r,
+				    buf->pointer_size);
+		if (r.error) {
+			fprintf(stderr, "\nBad binary log record.\n");
+			break;
+		}
+	}
+
+	if (buf->dropped)
+		printf("%u %s lost\n", buf->dropped,
+			buf->dropped == 1 ? "message" : "messages");
+
+out:
+	unmap_memory();
+	free(strtab);
+}
+
 /* dump the cbmem console */
 static void dump_console(void)
 {
@@ -888,7 +1261,7 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTxVvh?]\n", name);
+	printf("usage: %s [-cCltTjxVvh?] [-B strtab]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -C | --coverage:                  dump coverage information\n"
@@ -897,6 +1270,8 @@ static void print_usage(const char *name, int exit_code)
 	     "   -r | --rawdump ID:                print rawdump of specific ID (in hex) of cbtable\n"
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
+	     "   -j | --spans:                     print boot spans as Chrome trace JSON\n"
+	     "   -B | --binary-log STRTAB:         print binary log using ramstage.strtab of the build\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1029,6 +1404,8 @@ int main(int argc, char** argv)
 	int print_rawdump = 0;
 	int print_timestamps = 0;
 	int machine_readable_timestamps = 0;
+	int print_spans = 0;
+	const char *binlog_strtab = NULL;
 	unsigned int rawdump_id = 0;
 
 	int opt, option_index = 0;
@@ -1038,6 +1415,8 @@ int main(int argc, char** argv)
 		{"list", 0, 0, 'l'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
+		{"spans", 0, 0, 'j'},
+		{"binary-log", required_argument, 0, 'B'},
 		{"hexdump", 0, 0, 'x'},
 		{"rawdump", required_argument, 0, 'r'},
 		{"verbose", 0, 0, 'V'},
@@ -1045,7 +1424,7 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "cCltTxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "cCltTjxVvh?r:B:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1078,6 +1457,14 @@ int main(int argc, char** argv)
 			machine_readable_timestamps = 1;
 			print_defaults = 0;
 			break;
+		case 'j':
+			print_spans = 1;
+			print_defaults = 0;
+			break;
+		case 'B':
+			binlog_strtab = optarg;
+			print_defaults = 0;
+			break;
 		case 'V':
 			verbose = 1;
 			break;
@@ -1183,6 +1570,12 @@ int main(int argc, char** argv)
 	if (print_defaults || print_timestamps)
 		dump_timestamps(machine_readable_timestamps);
 
+	if (print_spans)
+		dump_spans();
+
+	if (binlog_strtab)
+		dump_binlog(binlog_strtab);
+
 	close(mem_fd);
 	return 0;
 }